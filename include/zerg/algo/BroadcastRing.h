@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include <zerg/tool/wait_strategy.h>
+
+namespace zerg {
+/**
+ * single producer multiple consumer broadcast ring (Disruptor style)
+ * every consumer sees every entry through its own sequence cursor, one write serves N readers without copy
+ * producer is gated by the slowest consumer, a consumer can depend on other consumers so that it only
+ * sees entries they have already processed, e.g. logger after book builder
+ * all consumers must be added before the producer starts
+ *
+ * producer: int64_t seq; T& e = ring.claim(seq); fill e; ring.publish(seq);
+ * consumer: c->poll([](const T& e, int64_t seq) { ... });
+ */
+template <typename T, typename TWait = BusySpinWait>
+class BroadcastRing {
+private:
+    static constexpr size_t CacheLineSize = 64;
+
+public:
+    struct alignas(CacheLineSize) Sequence {
+        std::atomic<int64_t> value{-1};
+
+        int64_t load() const noexcept { return value.load(std::memory_order_acquire); }
+    };
+
+    class Consumer {
+    public:
+        Consumer(BroadcastRing *ring, std::vector<const Sequence *> deps) : ring_(ring), deps_(std::move(deps)) {}
+
+        /**
+         * @return the highest sequence this consumer may process, -1 if nothing published yet
+         */
+        int64_t available() const noexcept {
+            int64_t avail = ring_->cursor_.load();
+            for (auto *dep : deps_) avail = std::min(avail, dep->load());
+            return avail;
+        }
+
+        /**
+         * process all available entries with f(const T&, int64_t seq) in one batch
+         * @return number of entries processed
+         */
+        template <typename F>
+        size_t poll(F &&f) {
+            int64_t next = seq_.value.load(std::memory_order_relaxed) + 1;
+            int64_t avail = available();
+            if (avail < next) return 0;
+            for (int64_t i = next; i <= avail; ++i) f(ring_->slots_[i & ring_->mask_], i);
+            seq_.value.store(avail, std::memory_order_release);
+            ring_->wait_.notify_all();
+            return static_cast<size_t>(avail - next + 1);
+        }
+
+        /**
+         * block with TWait until there is entry to process, then poll
+         */
+        template <typename F>
+        size_t wait_and_poll(F &&f) {
+            int64_t next = seq_.value.load(std::memory_order_relaxed) + 1;
+            ring_->wait_.wait([&] { return available() >= next; });
+            return poll(std::forward<F>(f));
+        }
+
+        const Sequence &sequence() const noexcept { return seq_; }
+
+    private:
+        BroadcastRing *ring_;
+        Sequence seq_;
+        std::vector<const Sequence *> deps_;
+    };
+
+    /**
+     * @param capacity round up to power of 2
+     */
+    explicit BroadcastRing(size_t capacity) {
+        if (capacity < 2) throw std::invalid_argument("size < 2");
+        size_t n = 1;
+        while (n < capacity) n <<= 1;
+        slots_.resize(n);
+        mask_ = n - 1;
+    }
+
+    // non-copyable and non-movable
+    BroadcastRing(const BroadcastRing &) = delete;
+    BroadcastRing &operator=(const BroadcastRing &) = delete;
+
+    /**
+     * @param deps consumers whose processed entries this consumer sees, empty means follow the producer
+     */
+    Consumer *add_consumer(std::initializer_list<const Consumer *> deps = {}) {
+        if (cursor_.load() >= 0) throw std::runtime_error("add consumer after publish");
+        std::vector<const Sequence *> dep_seqs;
+        for (auto *dep : deps) {
+            dep_seqs.push_back(&dep->sequence());
+            // only the tail of each dependency chain needs to gate the producer
+            gating_.erase(std::remove(gating_.begin(), gating_.end(), &dep->sequence()), gating_.end());
+        }
+        consumers_.emplace_back(new Consumer(this, std::move(dep_seqs)));
+        gating_.push_back(&consumers_.back()->sequence());
+        return consumers_.back().get();
+    }
+
+    /**
+     * wait until the slowest consumer frees the slot, must be followed by publish(seq)
+     */
+    T &claim(int64_t &seq) {
+        seq = next_++;
+        int64_t wrap_point = seq - static_cast<int64_t>(slots_.size());
+        if (wrap_point > cached_gating_) {
+            wait_.wait([&] {
+                cached_gating_ = min_gating();
+                return wrap_point <= cached_gating_;
+            });
+        }
+        return slots_[seq & mask_];
+    }
+
+    bool try_claim(int64_t &seq) {
+        int64_t wrap_point = next_ - static_cast<int64_t>(slots_.size());
+        if (wrap_point > cached_gating_) {
+            cached_gating_ = min_gating();
+            if (wrap_point > cached_gating_) return false;
+        }
+        seq = next_++;
+        return true;
+    }
+
+    T &operator[](int64_t seq) noexcept { return slots_[seq & mask_]; }
+
+    void publish(int64_t seq) {
+        cursor_.value.store(seq, std::memory_order_release);
+        wait_.notify_all();
+    }
+
+    void push(const T &v) {
+        int64_t seq;
+        claim(seq) = v;
+        publish(seq);
+    }
+
+    bool try_push(const T &v) {
+        int64_t seq;
+        if (!try_claim(seq)) return false;
+        slots_[seq & mask_] = v;
+        publish(seq);
+        return true;
+    }
+
+    int64_t cursor() const noexcept { return cursor_.load(); }
+
+    size_t capacity() const noexcept { return slots_.size(); }
+
+private:
+    int64_t min_gating() const noexcept {
+        int64_t ret = next_ - 1;
+        for (auto *s : gating_) ret = std::min(ret, s->load());
+        return ret;
+    }
+
+    std::vector<T> slots_;
+    size_t mask_{0};
+    std::vector<std::unique_ptr<Consumer>> consumers_;
+    std::vector<const Sequence *> gating_;
+
+    // producer only
+    alignas(CacheLineSize) int64_t next_{0};
+    int64_t cached_gating_{-1};
+
+    Sequence cursor_;
+    alignas(CacheLineSize) TWait wait_;
+};
+}  // namespace zerg
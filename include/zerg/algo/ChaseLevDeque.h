@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace zerg {
+/**
+ * Chase-Lev work stealing deque (Le, Pop, Cohen, Nardelli, "Correct and Efficient Work-Stealing for
+ * Weak Memory Models", PPoPP 2013)
+ * owner thread push()/take() at the bottom (LIFO), any thread steal() at the top (FIFO)
+ * T must be trivially copyable, typically a task pointer, the buffer grows on demand and old buffers
+ * are kept until destruction since a thief may still read them
+ */
+template <typename T>
+class ChaseLevDeque {
+private:
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+    static constexpr size_t CacheLineSize = 64;
+
+    struct Buffer {
+        explicit Buffer(int64_t capacity) : mask(capacity - 1), slots(new std::atomic<T>[capacity]) {}
+        int64_t capacity() const noexcept { return mask + 1; }
+        T get(int64_t i) const noexcept { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T v) noexcept { slots[i & mask].store(v, std::memory_order_relaxed); }
+        const int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+public:
+    /**
+     * @param capacity initial capacity, round up to power of 2
+     */
+    explicit ChaseLevDeque(int64_t capacity = 1024) {
+        int64_t n = 2;
+        while (n < capacity) n <<= 1;
+        buffers_.emplace_back(new Buffer(n));
+        buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    // non-copyable and non-movable
+    ChaseLevDeque(const ChaseLevDeque &) = delete;
+    ChaseLevDeque &operator=(const ChaseLevDeque &) = delete;
+
+    /**
+     * owner only
+     */
+    void push(T v) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        Buffer *a = buffer_.load(std::memory_order_relaxed);
+        if (b - t > a->capacity() - 1) a = grow(a, t, b);
+        a->put(b, v);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * owner only, newest first
+     */
+    bool take(T &out) {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer *a = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        out = a->get(b);
+        if (t == b) {
+            // last element, race with thieves
+            bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * any thread, oldest first, false if empty or lost the race
+     */
+    bool steal(T &out) {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        Buffer *a = buffer_.load(std::memory_order_acquire);
+        T v = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+        out = v;
+        return true;
+    }
+
+    int64_t size() const noexcept {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? b - t : 0;
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+
+private:
+    Buffer *grow(Buffer *a, int64_t t, int64_t b) {
+        auto *na = new Buffer(a->capacity() * 2);
+        for (int64_t i = t; i < b; ++i) na->put(i, a->get(i));
+        buffers_.emplace_back(na);
+        buffer_.store(na, std::memory_order_release);
+        return na;
+    }
+
+    alignas(CacheLineSize) std::atomic<int64_t> top_{0};
+    alignas(CacheLineSize) std::atomic<int64_t> bottom_{0};
+    alignas(CacheLineSize) std::atomic<Buffer *> buffer_{nullptr};
+    std::vector<std::unique_ptr<Buffer>> buffers_;  // owner only
+};
+}  // namespace zerg
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <zerg/tool/epoch.h>
+#include <zerg/tool/spin_lock.h>
+
+namespace zerg {
+/**
+ * concurrent open addressing hash map for shared lookups like ukey -> UkeyContext*
+ * reads never wait: a slot with an insert in flight (BUSY) is skipped, the key is not visible until that
+ * insert completes. inserts claim slots by CAS on the slot state, wait only for an insert in flight on the same
+ * slot (keys stay unique) and for a resize in progress, resize copies into a new table while readers keep reading the
+ * old one. Readers pin an EpochDomain of the map (one handle per thread, registered on its first read), a replaced
+ * table is freed by a later resize once no reader can still see it, so insert/erase churn does not pile up tables.
+ * K and V must be trivially copyable, V is stored in std::atomic so pointers and arithmetic types fit best.
+ * erased slots become tombstones and are dropped by the next resize, of the same size when mostly tombstones.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class ConcurrentHashMap {
+private:
+    static_assert(std::is_trivially_copyable<K>::value, "K must be trivially copyable");
+    static_assert(std::is_trivially_copyable<V>::value, "V must be trivially copyable");
+
+    enum : uint32_t { EMPTY = 0, BUSY = 1, READY = 2, ERASED = 3 };
+
+    struct Slot {
+        std::atomic<uint32_t> state{EMPTY};
+        K key;
+        std::atomic<V> value;
+    };
+
+    struct Table {
+        explicit Table(size_t capacity) : mask(capacity - 1), slots(new Slot[capacity]) {}
+        size_t capacity() const noexcept { return mask + 1; }
+        const size_t mask;
+        std::unique_ptr<Slot[]> slots;
+        alignas(64) std::atomic<size_t> used{0};  // claimed slots including tombstones
+    };
+
+public:
+    explicit ConcurrentHashMap(size_t capacity = 1024) {
+        size_t n = 16;
+        while (n < capacity * 2) n <<= 1;
+        current_.reset(new Table(n));
+        table_.store(current_.get(), std::memory_order_release);
+    }
+
+    // non-copyable and non-movable
+    ConcurrentHashMap(const ConcurrentHashMap &) = delete;
+    ConcurrentHashMap &operator=(const ConcurrentHashMap &) = delete;
+
+    bool find(const K &key, V &out) const {
+        ReadGuard guard(reader());
+        const Slot *slot = lookup(table_.load(std::memory_order_acquire), key);
+        if (slot == nullptr) return false;
+        out = slot->value.load(std::memory_order_acquire);
+        return true;
+    }
+
+    V get(const K &key, V dft = V()) const {
+        V out;
+        return find(key, out) ? out : dft;
+    }
+
+    bool contains(const K &key) const {
+        ReadGuard guard(reader());
+        return lookup(table_.load(std::memory_order_acquire), key);
+    }
+
+    /**
+     * @return true if key is newly inserted, false if value of existing key is replaced
+     */
+    bool insert_or_assign(const K &key, const V &value) { return insert(key, value, true); }
+
+    /**
+     * @return true if key is newly inserted, false if key exists and value is untouched
+     */
+    bool insert(const K &key, const V &value) { return insert(key, value, false); }
+
+    bool erase(const K &key) noexcept {
+        std::shared_lock<RWSpinLock> lock(resize_lock_);
+        Slot *slot = const_cast<Slot *>(lookup(table_.load(std::memory_order_acquire), key));
+        if (slot == nullptr) return false;
+        uint32_t expected = READY;
+        if (!slot->state.compare_exchange_strong(expected, ERASED, std::memory_order_acq_rel)) return false;
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_t size() const noexcept { return size_.load(std::memory_order_relaxed); }
+
+    bool empty() const noexcept { return size() == 0; }
+
+    size_t capacity() const noexcept { return table_.load(std::memory_order_acquire)->capacity(); }
+
+    /**
+     * slots held by the current table and the replaced ones not freed yet
+     */
+    size_t retained_capacity() const {
+        std::lock_guard<RWSpinLock> lock(resize_lock_);
+        size_t n = current_->capacity();
+        for (const auto &r : retired_) n += r.first->capacity();
+        return n;
+    }
+
+    /**
+     * weakly consistent walk over the current table, fn(const K&, V)
+     */
+    template <typename F>
+    void for_each(F &&fn) const {
+        ReadGuard guard(reader());
+        const Table *t = table_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < t->capacity(); ++i) {
+            const Slot &s = t->slots[i];
+            if (s.state.load(std::memory_order_acquire) == READY) fn(s.key, s.value.load(std::memory_order_acquire));
+        }
+    }
+
+private:
+    using Handle = EpochDomain::Handle;
+
+    struct ReadGuard {
+        explicit ReadGuard(Handle &h) : handle(h) { handle.enter(); }
+        ~ReadGuard() { handle.exit(); }
+        Handle &handle;
+    };
+
+    // handle of this thread in one map, released at thread exit if the map is still alive
+    struct ReaderSlot {
+        uint64_t id;
+        std::weak_ptr<EpochDomain> domain;
+        Handle *handle;
+        ReaderSlot(uint64_t i, const std::shared_ptr<EpochDomain> &d, Handle *h) : id(i), domain(d), handle(h) {}
+        ReaderSlot(ReaderSlot &&) = default;
+        ReaderSlot &operator=(ReaderSlot &&) = default;
+        ~ReaderSlot() {
+            if (auto d = domain.lock()) d->unregister_thread(handle);
+        }
+    };
+
+    static uint64_t next_id() noexcept {
+        static std::atomic<uint64_t> id{0};
+        return id.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    Handle &reader() const {
+        thread_local std::vector<ReaderSlot> slots;
+        for (auto &s : slots) {
+            if (s.id == id_) return *s.handle;
+        }
+        // first read of this map on this thread, forget maps destroyed since
+        for (size_t i = 0; i < slots.size();) {
+            if (slots[i].domain.expired()) {
+                slots[i] = std::move(slots.back());
+                slots.pop_back();
+            } else {
+                ++i;
+            }
+        }
+        slots.emplace_back(id_, domain_, domain_->register_thread());
+        return *slots.back().handle;
+    }
+
+    static size_t mix(size_t h) noexcept {
+        // murmur3 finalizer, std::hash of integers is identity which clusters under linear probing
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    size_t hash_of(const K &key) const noexcept { return mix(hasher_(key)); }
+
+    static uint32_t wait_not_busy(const Slot &s) noexcept {
+        uint32_t state;
+        SpinBackoff backoff;
+        while ((state = s.state.load(std::memory_order_acquire)) == BUSY) backoff.pause();
+        return state;
+    }
+
+    const Slot *lookup(const Table *t, const K &key) const noexcept {
+        size_t idx = hash_of(key) & t->mask;
+        for (size_t n = 0; n <= t->mask; ++n, idx = (idx + 1) & t->mask) {
+            const Slot &s = t->slots[idx];
+            uint32_t state = s.state.load(std::memory_order_acquire);
+            if (state == EMPTY) return nullptr;
+            // key is being written, the insert is not done so it can not be the key we look for yet,
+            // and a key lives in one slot only, so probe on instead of waiting for the writer
+            if (state == BUSY) continue;
+            if (equal_(s.key, key)) return state == READY ? &s : nullptr;
+        }
+        return nullptr;
+    }
+
+    bool insert(const K &key, const V &value, bool assign) {
+        while (true) {
+            Table *t;
+            {
+                std::shared_lock<RWSpinLock> lock(resize_lock_);
+                t = table_.load(std::memory_order_acquire);
+                if (t->used.load(std::memory_order_relaxed) * 2 < t->capacity()) {
+                    int ret = insert_into(t, key, value, assign);
+                    if (ret >= 0) return ret == 1;
+                }
+            }
+            grow(t);
+        }
+    }
+
+    /**
+     * @return 1 inserted, 0 existed, -1 table full
+     */
+    int insert_into(Table *t, const K &key, const V &value, bool assign) {
+        size_t idx = hash_of(key) & t->mask;
+        for (size_t n = 0; n <= t->mask; ++n, idx = (idx + 1) & t->mask) {
+            Slot &s = t->slots[idx];
+            uint32_t state = s.state.load(std::memory_order_acquire);
+            while (true) {
+                if (state == EMPTY) {
+                    if (s.state.compare_exchange_strong(state, BUSY, std::memory_order_acquire)) {
+                        s.key = key;
+                        s.value.store(value, std::memory_order_relaxed);
+                        s.state.store(READY, std::memory_order_release);
+                        t->used.fetch_add(1, std::memory_order_relaxed);
+                        size_.fetch_add(1, std::memory_order_relaxed);
+                        return 1;
+                    }
+                    continue;  // lost the race, look at what the winner put there
+                }
+                if (state == BUSY) {
+                    state = wait_not_busy(s);
+                    continue;
+                }
+                if (!equal_(s.key, key)) break;  // probe next slot
+                if (state == READY) {
+                    if (assign) s.value.store(value, std::memory_order_release);
+                    return 0;
+                }
+                // tombstone of the same key, revive it
+                if (s.state.compare_exchange_strong(state, BUSY, std::memory_order_acquire)) {
+                    s.value.store(value, std::memory_order_relaxed);
+                    s.state.store(READY, std::memory_order_release);
+                    size_.fetch_add(1, std::memory_order_relaxed);
+                    return 1;
+                }
+            }
+        }
+        return -1;
+    }
+
+    void grow(Table *old) {
+        std::lock_guard<RWSpinLock> lock(resize_lock_);
+        if (table_.load(std::memory_order_relaxed) != old) return;  // someone else did it
+        size_t live = size_.load(std::memory_order_relaxed);
+        // same capacity when mostly tombstones, otherwise double
+        size_t n = old->capacity();
+        while (n < live * 4) n <<= 1;
+        auto *t = new Table(n);
+        for (size_t i = 0; i < old->capacity(); ++i) {
+            const Slot &s = old->slots[i];
+            if (s.state.load(std::memory_order_relaxed) != READY) continue;
+            size_t idx = hash_of(s.key) & t->mask;
+            while (t->slots[idx].state.load(std::memory_order_relaxed) != EMPTY) idx = (idx + 1) & t->mask;
+            Slot &d = t->slots[idx];
+            d.key = s.key;
+            d.value.store(s.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            d.state.store(READY, std::memory_order_relaxed);
+            t->used.fetch_add(1, std::memory_order_relaxed);
+        }
+        table_.store(t, std::memory_order_release);
+        // readers that pinned before the store may still walk old, it waits for two epochs
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        retired_.emplace_back(std::move(current_), domain_->epoch());
+        current_.reset(t);
+        domain_->try_advance();
+        uint64_t safe = domain_->epoch();
+        size_t kept = 0;
+        for (auto &r : retired_) {
+            if (r.second + 2 > safe) retired_[kept++] = std::move(r);
+        }
+        retired_.resize(kept);
+    }
+
+    alignas(64) std::atomic<Table *> table_{nullptr};
+    alignas(64) std::atomic<size_t> size_{0};
+    alignas(64) mutable RWSpinLock resize_lock_;
+    // guarded by resize_lock_ exclusive
+    std::unique_ptr<Table> current_;
+    std::vector<std::pair<std::unique_ptr<Table>, uint64_t>> retired_;  // replaced table, epoch it was replaced in
+    std::shared_ptr<EpochDomain> domain_{std::make_shared<EpochDomain>()};
+    const uint64_t id_{next_id()};
+    Hash hasher_;
+    KeyEqual equal_;
+};
+}  // namespace zerg
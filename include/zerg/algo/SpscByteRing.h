@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace zerg {
+/**
+ * single producer single consumer byte ring (bip-buffer) for variable length messages
+ * every reservation is contiguous, when the tail space is too small the producer skips it and
+ * wraps to the start (like Channel::PublishVar), so consumer can always parse messages in place
+ *
+ * producer: char* p = reserve(n); fill p; commit(n);
+ * consumer: auto s = peek(); parse s.data / s.size; release(consumed);
+ */
+class SpscByteRing {
+public:
+    static constexpr size_t CacheLineSize = 64;
+
+    struct Span {
+        const char *data{nullptr};
+        size_t size{0};
+        bool empty() const noexcept { return size == 0; }
+    };
+
+private:
+    // checked before buffer_ is allocated, a throwing constructor body would leak it
+    static size_t checked_capacity(size_t capacity) {
+        if (capacity < 2) throw std::invalid_argument("size < 2");
+        return capacity;
+    }
+
+    const size_t capacity_;
+    char *const buffer_;
+
+    // producer only
+    alignas(CacheLineSize) size_t reservePos_{0};
+    size_t reserveSize_{0};
+    bool reserveWrapped_{false};
+
+    alignas(CacheLineSize) std::atomic<size_t> writeIndex_{0};
+    std::atomic<size_t> watermark_;  // end of valid data before the wrap
+    alignas(CacheLineSize) std::atomic<size_t> readIndex_{0};
+
+    char padding_[CacheLineSize - sizeof(readIndex_)];
+
+public:
+    explicit SpscByteRing(const size_t capacity)
+        : capacity_(checked_capacity(capacity)),
+          buffer_(static_cast<char *>(operator new[](capacity_, std::align_val_t(CacheLineSize)))),
+          watermark_(capacity_) {}
+
+    ~SpscByteRing() { operator delete[](buffer_, std::align_val_t(CacheLineSize)); }
+
+    // non-copyable and non-movable
+    SpscByteRing(const SpscByteRing &) = delete;
+    SpscByteRing &operator=(const SpscByteRing &) = delete;
+
+    /**
+     * @return contiguous space of n bytes, nullptr if no space, must be followed by commit()
+     */
+    char *reserve(size_t n) noexcept {
+        auto const write = writeIndex_.load(std::memory_order_relaxed);
+        auto const read = readIndex_.load(std::memory_order_acquire);
+        reserveWrapped_ = false;
+        if (write >= read) {
+            if (capacity_ - write >= n) {
+                reservePos_ = write;
+            } else if (read > n) {
+                // skip the tail, write must never catch up read, otherwise it looks empty
+                reservePos_ = 0;
+                reserveWrapped_ = true;
+            } else {
+                return nullptr;
+            }
+        } else if (read - write > n) {
+            reservePos_ = write;
+        } else {
+            return nullptr;
+        }
+        reserveSize_ = n;
+        return buffer_ + reservePos_;
+    }
+
+    /**
+     * publish the first n bytes of last reservation, n <= reserved size
+     */
+    void commit(size_t n) noexcept {
+        if (n > reserveSize_) n = reserveSize_;
+        auto const write = writeIndex_.load(std::memory_order_relaxed);
+        if (reserveWrapped_) {
+            watermark_.store(write, std::memory_order_relaxed);
+        } else if (reservePos_ + n > watermark_.load(std::memory_order_relaxed)) {
+            watermark_.store(capacity_, std::memory_order_relaxed);
+        }
+        writeIndex_.store(reservePos_ + n, std::memory_order_release);
+        reserveSize_ = 0;
+        reserveWrapped_ = false;
+    }
+
+    bool try_write(const void *data, size_t n) noexcept {
+        char *p = reserve(n);
+        if (p == nullptr) return false;
+        memcpy(p, data, n);
+        commit(n);
+        return true;
+    }
+
+    /**
+     * @return contiguous readable bytes, may hold several messages
+     */
+    Span peek() noexcept {
+        auto const write = writeIndex_.load(std::memory_order_acquire);
+        auto const watermark = watermark_.load(std::memory_order_relaxed);
+        auto read = readIndex_.load(std::memory_order_relaxed);
+        if (read == watermark && write < read) {
+            // producer wrapped, the tail after watermark is skipped
+            read = 0;
+            readIndex_.store(0, std::memory_order_release);
+        }
+        size_t size = write < read ? watermark - read : write - read;
+        return Span{buffer_ + read, size};
+    }
+
+    /**
+     * this call must follow peek(), n <= peek().size
+     */
+    void release(size_t n) noexcept {
+        auto const read = readIndex_.load(std::memory_order_relaxed);
+        readIndex_.store(read + n, std::memory_order_release);
+    }
+
+    bool empty() const noexcept {
+        return writeIndex_.load(std::memory_order_acquire) == readIndex_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const noexcept { return capacity_; }
+};
+}  // namespace zerg
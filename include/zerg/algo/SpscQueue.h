@@ -3,9 +3,13 @@
 #include <atomic>
 #include <stdexcept>
 #include <type_traits>
+#include <zerg/tool/wait_strategy.h>
 
 namespace zerg {
-template <typename T>
+/**
+ * TWait decides how emplace() waits for space and wait_front() waits for data, see wait_strategy.h
+ */
+template <typename T, typename TWait = BusySpinWait>
 class SpscQueue {
 private:
     static constexpr size_t CacheLineSize = 64;
@@ -23,6 +27,8 @@ private:
     // Padding to avoid adjacent allocations to share cache line with tailIndex_
     char padding_[CacheLineSize - sizeof(tailIndex_)];
 
+    alignas(CacheLineSize) TWait wait_;
+
 public:
     explicit SpscQueue(const size_t capacity)
         : capacity_(capacity),
@@ -52,11 +58,12 @@ public:
             nextHead = 0;
         }
 
-        while (nextHead == tailIndex_.load(std::memory_order_acquire))
-            ;  // no space to push element in, then while loop until there is some space
+        // no space to push element in, then wait until there is some space
+        wait_.wait([&] { return nextHead != tailIndex_.load(std::memory_order_acquire); });
 
         new (&slots_[head + PaddingCountOfT]) T(std::forward<Args>(args)...);
         headIndex_.store(nextHead, std::memory_order_release);
+        wait_.notify_one();
     }
 
     template <typename... Args>
@@ -72,6 +79,7 @@ public:
         }
         new (&slots_[head + PaddingCountOfT]) T(std::forward<Args>(args)...);
         headIndex_.store(nextHead, std::memory_order_release);
+        wait_.notify_one();
         return true;
     }
 
@@ -107,6 +115,15 @@ public:
         return &slots_[tail + PaddingCountOfT];
     }
 
+    /**
+     * block with TWait until there is element ready for consume
+     */
+    T *wait_front() noexcept {
+        auto const tail = tailIndex_.load(std::memory_order_relaxed);
+        wait_.wait([&] { return headIndex_.load(std::memory_order_acquire) != tail; });
+        return &slots_[tail + PaddingCountOfT];
+    }
+
     /**
      * this call should follow size(), make sure it must have item to consume
      */
@@ -125,6 +142,7 @@ public:
             nextTail = 0;
         }
         tailIndex_.store(nextTail, std::memory_order_release);
+        wait_.notify_one();
     }
 
     size_t size() const noexcept {
@@ -151,8 +169,7 @@ public:
             nextHead = 0;
         }
 
-        while (nextHead == tailIndex_.load(std::memory_order_acquire))
-            ;
+        wait_.wait([&] { return nextHead != tailIndex_.load(std::memory_order_acquire); });
 
         return slots_[head + PaddingCountOfT];
     }
@@ -163,6 +180,7 @@ public:
      */
     void advance_head(size_t nextHead){
         headIndex_.store(nextHead, std::memory_order_release);
+        wait_.notify_one();
     }
 };
 } 
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace zerg {
@@ -39,39 +43,188 @@ public:
         auto node = new DependencyNode(static_cast<long>(ind), p);
         ++ind;
         tree.push_back(node);
+        sorted = false;
         return ind - 1;
     }
 
-    // add dependency
+    // add dependency, dependent needs dependency computed first
     int AddDependency(size_t dependent, size_t dependency) {
-        if (dependent > ind || dependency > ind) return -1;
+        if (dependent >= ind || dependency >= ind) return -1;
         tree[dependent]->dependencies.push_back(dependency);
+        sorted = false;  // dependents, levels and rank are rebuilt on the next use
         return 0;
     }
 
-    // perform the topological sort
+    /**
+     * topological sort, dependencies first (iterative DFS post order, no recursion depth limit)
+     * also builds the dependents index and the level sets used by the incremental recompute
+     * @throw std::invalid_argument naming the nodes of a cycle, "1 -> 3 -> 1" reads 1 depends on 3 depends on 1
+     */
     void Sort() {
-        std::vector<bool> explored(tree.size(), false);
-        sorted_list.resize(tree.size(), 0);
-        size_t t = tree.size();
-        for (size_t i = 0; i < tree.size(); ++i) {
-            if (explored[i] == false) {
-                Sort_using_DFS(tree, explored, i, sorted_list, t);
+        size_t n = tree.size();
+        std::vector<uint8_t> state(n, 0);  // 0 new, 1 on the DFS stack, 2 done
+        std::vector<std::pair<size_t, size_t>> stack;  // node, next dependency to visit
+        sorted_list.clear();
+        sorted_list.reserve(n);
+        for (size_t root = 0; root < n; ++root) {
+            if (state[root] != 0) continue;
+            stack.emplace_back(root, 0);
+            state[root] = 1;
+            while (!stack.empty()) {
+                auto& top = stack.back();
+                auto& deps = tree[top.first]->dependencies;
+                if (top.second < deps.size()) {
+                    size_t dep = deps[top.second++];
+                    if (state[dep] == 1) throw std::invalid_argument("DAG: dependency cycle " + CyclePath(stack, dep));
+                    if (state[dep] == 0) {
+                        state[dep] = 1;
+                        stack.emplace_back(dep, 0);
+                    }
+                } else {
+                    state[top.first] = 2;
+                    sorted_list.push_back(top.first);
+                    stack.pop_back();
+                }
             }
         }
-        std::reverse(sorted_list.begin(), sorted_list.end());
+        BuildLevels();
+        dirty.assign(n, 0);
+        sorted = true;
     }
 
-    void Sort_using_DFS(std::vector<DependencyNode*>& graph, std::vector<bool>& explored, size_t i,
-                        std::vector<size_t>& sorted, size_t& t) {
-        explored[i] = true;
-        for (size_t j = 0; j < graph[i]->dependencies.size(); ++j) {
-            if (explored[graph[i]->dependencies[j]] == false) {
-                Sort_using_DFS(graph, explored, graph[i]->dependencies[j], sorted, t);
+    /**
+     * Kahn layering, level 0 has no dependency, nodes of level k only depend on levels < k
+     * so the nodes of one level can be computed together, valid after Sort()
+     */
+    const std::vector<std::vector<size_t>>& GetLevels() const { return levels; }
+
+    // nodes that list id as a dependency, valid after Sort()
+    const std::vector<size_t>& GetDependents(size_t id) const { return dependents[id]; }
+
+    /**
+     * incremental recompute: mark the inputs that changed, Recompute() then visits them and everything
+     * downstream of them exactly once, dependencies first
+     */
+    void MarkDirty(size_t id) {
+        EnsureSorted();
+        if (id < dirty.size()) dirty[id] = 1;
+    }
+
+    void MarkAllDirty() {
+        EnsureSorted();
+        std::fill(dirty.begin(), dirty.end(), 1);
+    }
+
+    bool IsDirty(size_t id) const { return id < dirty.size() && dirty[id]; }
+
+    /**
+     * the dirty nodes and all their transitive dependents, in sorted_list order
+     */
+    std::vector<size_t> Affected() {
+        EnsureSorted();
+        std::vector<uint8_t> seen(tree.size(), 0);
+        std::vector<size_t> ret;
+        for (size_t i = 0; i < dirty.size(); ++i) {
+            if (dirty[i] && !seen[i]) {
+                seen[i] = 1;
+                ret.push_back(i);
+            }
+        }
+        for (size_t k = 0; k < ret.size(); ++k) {
+            for (size_t d : dependents[ret[k]]) {
+                if (!seen[d]) {
+                    seen[d] = 1;
+                    ret.push_back(d);
+                }
+            }
+        }
+        std::sort(ret.begin(), ret.end(), [&](size_t a, size_t b) { return rank[a] < rank[b]; });
+        return ret;
+    }
+
+    /**
+     * fn(size_t id, T* p) for every affected node in topological order, then clears the dirty flags
+     * @return number of recomputed nodes
+     */
+    template <typename F>
+    size_t Recompute(F&& fn) {
+        auto nodes = Affected();
+        for (size_t id : nodes) fn(id, tree[id]->p);
+        std::fill(dirty.begin(), dirty.end(), 0);
+        return nodes.size();
+    }
+
+    /**
+     * like Recompute() but per level, fn(const std::vector<size_t>& ids) gets the affected nodes of one level,
+     * they do not depend on each other and can run in parallel (e.g. parallel_for over ids)
+     */
+    template <typename F>
+    size_t RecomputeLevels(F&& fn) {
+        auto nodes = Affected();
+        std::vector<std::vector<size_t>> batches(levels.size());
+        for (size_t id : nodes) batches[level_of[id]].push_back(id);
+        for (auto& batch : batches) {
+            if (!batch.empty()) fn(static_cast<const std::vector<size_t>&>(batch));
+        }
+        std::fill(dirty.begin(), dirty.end(), 0);
+        return nodes.size();
+    }
+
+private:
+    std::vector<std::vector<size_t>> dependents;
+    std::vector<std::vector<size_t>> levels;
+    std::vector<size_t> level_of;
+    std::vector<size_t> rank;  // position in sorted_list
+    std::vector<uint8_t> dirty;
+    bool sorted{false};  // cleared by AddNode / AddDependency
+
+    // re-sort after the graph changed, nodes marked dirty before stay dirty
+    void EnsureSorted() {
+        if (sorted) return;
+        std::vector<uint8_t> marked = std::move(dirty);
+        Sort();
+        for (size_t i = 0; i < marked.size() && i < dirty.size(); ++i) dirty[i] = marked[i];
+    }
+
+    std::string CyclePath(const std::vector<std::pair<size_t, size_t>>& stack, size_t dep) const {
+        std::string path;
+        bool in_cycle = false;
+        for (auto& frame : stack) {
+            if (frame.first == dep) in_cycle = true;
+            if (in_cycle) path += std::to_string(frame.first) + " -> ";
+        }
+        return path + std::to_string(dep);
+    }
+
+    void BuildLevels() {
+        size_t n = tree.size();
+        dependents.assign(n, {});
+        std::vector<size_t> in_degree(n, 0);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t dep : tree[i]->dependencies) {
+                dependents[dep].push_back(i);
+                ++in_degree[i];
+            }
+        }
+        rank.assign(n, 0);
+        for (size_t k = 0; k < n; ++k) rank[sorted_list[k]] = k;
+        levels.clear();
+        level_of.assign(n, 0);
+        std::vector<size_t> current;
+        for (size_t i = 0; i < n; ++i) {
+            if (in_degree[i] == 0) current.push_back(i);
+        }
+        while (!current.empty()) {
+            std::vector<size_t> next;
+            for (size_t id : current) {
+                level_of[id] = levels.size();
+                for (size_t d : dependents[id]) {
+                    if (--in_degree[d] == 0) next.push_back(d);
+                }
             }
+            levels.push_back(std::move(current));
+            current = std::move(next);
         }
-        --t;
-        sorted[t] = i;
     }
 };
 
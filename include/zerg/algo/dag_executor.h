@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <zerg/algo/dag.h>
+
+namespace zerg {
+/**
+ * runs the nodes of a DAG on a thread pool, a node is dispatched as soon as all its dependencies finished
+ * every node keeps an atomic count of unfinished dependencies, the thread finishing a node decrements the
+ * counters of its dependents, runs one newly ready dependent itself and enqueues the others
+ * nothing is recursive, graphs of any depth are fine. The graph is copied at construction, build a new
+ * executor after changing the DAG. run() can be called many times, timings are kept from the last run.
+ *
+ *   DagExecutor<Feature> exec(dag);
+ *   exec.run(pool, [](size_t id, Feature* f) { f->calc(); });
+ *   printf("%s", exec.report().c_str());
+ */
+template <typename T>
+class DagExecutor {
+public:
+    struct NodeStat {
+        int64_t start_ns{0};  // since start of run
+        int64_t end_ns{0};
+        int64_t duration_ns() const noexcept { return end_ns - start_ns; }
+    };
+
+    /**
+     * @throw std::invalid_argument on bad dependency index or cycle
+     */
+    explicit DagExecutor(const DAG<T>& dag) : size_(dag.tree.size()), dependents_(size_), in_degree_(size_, 0) {
+        for (size_t i = 0; i < size_; ++i) {
+            objects_.push_back(dag.tree[i]->p);
+            for (size_t dep : dag.tree[i]->dependencies) {
+                if (dep >= size_) throw std::invalid_argument("DagExecutor: bad dependency " + std::to_string(dep));
+                dependents_[dep].push_back(i);
+                ++in_degree_[i];
+            }
+        }
+        build_order();
+        stats_.resize(size_);
+    }
+
+    size_t size() const noexcept { return size_; }
+
+    /**
+     * dependencies first, Kahn order
+     */
+    const std::vector<size_t>& order() const noexcept { return order_; }
+
+    /**
+     * blocks until every node ran, fn(size_t id, T* p)
+     * if fn throws, the nodes not yet started are skipped and the first exception is rethrown here
+     */
+    template <typename TPool, typename F>
+    void run(TPool& pool, F&& fn) {
+        if (size_ == 0) return;
+        auto ctx = std::make_shared<RunContext>(size_);
+        for (size_t i = 0; i < size_; ++i) ctx->remaining[i].store(in_degree_[i], std::memory_order_relaxed);
+        ctx->body = [this, &fn](size_t id) { fn(id, objects_[id]); };
+        start_ = clock::now();
+        for (size_t root : roots_) {
+            pool.enqueue([this, ctx, root, &pool] { execute(pool, ctx, root); });
+        }
+        {
+            std::unique_lock<std::mutex> lock(ctx->mutex);
+            ctx->cond.wait(lock, [&] { return ctx->done.load(std::memory_order_acquire) == size_; });
+        }
+        wall_ns_ = elapsed_ns();
+        ctx->body = nullptr;
+        if (ctx->error) std::rethrow_exception(ctx->error);
+    }
+
+    /**
+     * single thread run in topological order, same timing output
+     */
+    template <typename F>
+    void run_serial(F&& fn) {
+        start_ = clock::now();
+        for (size_t id : order_) {
+            stats_[id].start_ns = elapsed_ns();
+            fn(id, objects_[id]);
+            stats_[id].end_ns = elapsed_ns();
+        }
+        wall_ns_ = elapsed_ns();
+    }
+
+    const std::vector<NodeStat>& stats() const noexcept { return stats_; }
+
+    int64_t wall_ns() const noexcept { return wall_ns_; }
+
+    int64_t total_ns() const noexcept {
+        int64_t sum = 0;
+        for (auto& s : stats_) sum += s.duration_ns();
+        return sum;
+    }
+
+    /**
+     * longest chain of measured durations, the lower bound of wall time with unlimited threads
+     * @return node ids, dependencies first
+     */
+    std::vector<size_t> critical_path() const {
+        std::vector<int64_t> dist(size_, 0);
+        std::vector<int64_t> prev(size_, -1);
+        // dependents come after their dependencies in order_, relax forward
+        for (size_t id : order_) {
+            dist[id] += stats_[id].duration_ns();
+            for (size_t d : dependents_[id]) {
+                if (dist[id] > dist[d]) {
+                    dist[d] = dist[id];
+                    prev[d] = static_cast<int64_t>(id);
+                }
+            }
+        }
+        std::vector<size_t> path;
+        if (size_ == 0) return path;
+        int64_t cur = std::max_element(dist.begin(), dist.end()) - dist.begin();
+        for (; cur >= 0; cur = prev[cur]) path.push_back(static_cast<size_t>(cur));
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    int64_t critical_path_ns() const {
+        int64_t sum = 0;
+        for (size_t id : critical_path()) sum += stats_[id].duration_ns();
+        return sum;
+    }
+
+    /**
+     * summary of last run and the slowest nodes, name(id) labels nodes in the output
+     */
+    std::string report(size_t top_n = 10, const std::function<std::string(size_t)>& name = nullptr) const {
+        auto label = [&](size_t id) { return name ? name(id) : std::to_string(id); };
+        char buf[256];
+        std::string out;
+        int64_t total = total_ns();
+        snprintf(buf, sizeof(buf), "nodes %zu wall %.3fms cpu %.3fms parallelism %.2f critical path %.3fms\n", size_,
+                 wall_ns_ / 1e6, total / 1e6, wall_ns_ > 0 ? double(total) / wall_ns_ : 0.0, critical_path_ns() / 1e6);
+        out += buf;
+        out += "critical path:";
+        for (size_t id : critical_path()) out += " " + label(id);
+        out += "\n";
+        std::vector<size_t> ids(size_);
+        for (size_t i = 0; i < size_; ++i) ids[i] = i;
+        top_n = std::min(top_n, size_);
+        std::partial_sort(ids.begin(), ids.begin() + top_n, ids.end(),
+                          [&](size_t a, size_t b) { return stats_[a].duration_ns() > stats_[b].duration_ns(); });
+        for (size_t i = 0; i < top_n; ++i) {
+            const auto& s = stats_[ids[i]];
+            snprintf(buf, sizeof(buf), "  %-24s %10.3fms start %10.3fms\n", label(ids[i]).c_str(), s.duration_ns() / 1e6,
+                     s.start_ns / 1e6);
+            out += buf;
+        }
+        return out;
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct RunContext {
+        explicit RunContext(size_t n) : remaining(new std::atomic<size_t>[n]) {}
+        std::unique_ptr<std::atomic<size_t>[]> remaining;
+        std::function<void(size_t)> body;
+        std::atomic<size_t> done{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable cond;
+    };
+
+    int64_t elapsed_ns() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start_).count();
+    }
+
+    void build_order() {
+        std::vector<size_t> in_degree = in_degree_;
+        for (size_t i = 0; i < size_; ++i) {
+            if (in_degree[i] == 0) roots_.push_back(i);
+        }
+        order_ = roots_;
+        for (size_t k = 0; k < order_.size(); ++k) {
+            for (size_t d : dependents_[order_[k]]) {
+                if (--in_degree[d] == 0) order_.push_back(d);
+            }
+        }
+        if (order_.size() != size_) throw std::invalid_argument("DagExecutor: dependency cycle");
+    }
+
+    template <typename TPool>
+    void execute(TPool& pool, const std::shared_ptr<RunContext>& ctx, size_t id) {
+        while (true) {
+            stats_[id].start_ns = elapsed_ns();
+            if (!ctx->failed.load(std::memory_order_relaxed)) {
+                try {
+                    ctx->body(id);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(ctx->mutex);
+                    if (!ctx->failed.exchange(true)) ctx->error = std::current_exception();
+                }
+            }
+            stats_[id].end_ns = elapsed_ns();
+
+            // keep one ready dependent for this thread, hand the rest to the pool
+            int64_t next = -1;
+            for (size_t d : dependents_[id]) {
+                if (ctx->remaining[d].fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+                if (next >= 0) {
+                    size_t ready = static_cast<size_t>(next);
+                    pool.enqueue([this, ctx, ready, &pool] { execute(pool, ctx, ready); });
+                }
+                next = static_cast<int64_t>(d);
+            }
+            if (ctx->done.fetch_add(1, std::memory_order_acq_rel) + 1 == size_) {
+                std::lock_guard<std::mutex> lock(ctx->mutex);
+                ctx->cond.notify_all();
+            }
+            if (next < 0) return;
+            id = static_cast<size_t>(next);
+        }
+    }
+
+    size_t size_;
+    std::vector<T*> objects_;
+    std::vector<std::vector<size_t>> dependents_;
+    std::vector<size_t> in_degree_;
+    std::vector<size_t> roots_;
+    std::vector<size_t> order_;
+    std::vector<NodeStat> stats_;
+    clock::time_point start_;
+    int64_t wall_ns_{0};
+};
+}  // namespace zerg
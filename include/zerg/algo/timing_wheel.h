@@ -0,0 +1,306 @@
+#pragma once
+
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <zerg/tool/task.h>
+
+namespace zerg {
+/**
+ * hierarchical hashed timing wheel (Varghese & Lauck), for many timers like order timeouts and throttles
+ * 4 levels of 256 slots cover 2^32 ticks, longer timers wait in the top level and get re-hashed.
+ * schedule and cancel are O(1): every timer is a node of an intrusive list, addressed by index in a
+ * node pool, a TimerId carries the index and a generation so a stale id never cancels a reused node.
+ * advance(now) runs every tick up to now, cascading higher levels down when a lower level wraps.
+ * single threaded, callbacks may schedule and cancel timers.
+ *
+ * TPayload is what a timer carries, TimingWheel uses SboTask and advance(now) calls it,
+ * with any other type use advance(now, fn) and fn(TimerId, TPayload&) is called for each expired timer
+ */
+template <typename TPayload>
+class TimingWheelT {
+private:
+    static constexpr int SLOT_BITS = 8;
+    static constexpr uint32_t SLOTS = 1u << SLOT_BITS;
+    static constexpr uint32_t MASK = SLOTS - 1;
+    static constexpr int LEVELS = 4;
+    static constexpr uint32_t SENTINELS = SLOTS * LEVELS + 1;  // one per slot and one for the expiring list
+    static constexpr uint32_t EXPIRING = SLOTS * LEVELS;
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct Node {
+        uint32_t prev{NIL};
+        uint32_t next{NIL};  // next free node when not linked
+        uint32_t gen{1};
+        uint8_t level{0};
+        bool active{false};
+        uint64_t expire{0};
+        TPayload payload{};
+    };
+
+public:
+    using TimerId = uint64_t;  // 0 is never a valid id
+
+    /**
+     * @param tick_ns resolution, timers fire on the first tick at or after their deadline
+     * @param now_ns origin of the wheel, same clock as later advance() calls
+     */
+    explicit TimingWheelT(uint64_t tick_ns = 1000000, uint64_t now_ns = 0, size_t reserve = 1024)
+        : tick_ns_(tick_ns == 0 ? 1 : tick_ns), origin_ns_(now_ns) {
+        nodes_.reserve(SENTINELS + reserve);
+        nodes_.resize(SENTINELS);
+        for (uint32_t i = 0; i < SENTINELS; ++i) nodes_[i].prev = nodes_[i].next = i;
+    }
+
+    TimingWheelT(const TimingWheelT &) = delete;
+    TimingWheelT &operator=(const TimingWheelT &) = delete;
+
+    TimerId schedule_at(uint64_t when_ns, TPayload payload) {
+        uint64_t tick = when_ns <= origin_ns_ ? 0 : (when_ns - origin_ns_ + tick_ns_ - 1) / tick_ns_;
+        return schedule_tick(tick, std::move(payload));
+    }
+
+    /**
+     * relative to the time of the last advance()
+     */
+    TimerId schedule_after(uint64_t delay_ns, TPayload payload) {
+        return schedule_tick(current_ + (delay_ns + tick_ns_ - 1) / tick_ns_, std::move(payload));
+    }
+
+    /**
+     * @return false if the timer already fired or was cancelled
+     */
+    bool cancel(TimerId id) {
+        uint32_t idx = static_cast<uint32_t>(id);
+        if (!valid(id)) return false;
+        unlink(idx);
+        release(idx);
+        return true;
+    }
+
+    bool pending(TimerId id) const noexcept { return valid(id); }
+
+    /**
+     * fire all timers due at now_ns, fn(TimerId, TPayload&)
+     * @return number of fired timers
+     */
+    template <typename F>
+    size_t advance(uint64_t now_ns, F &&fn) {
+        if (now_ns < origin_ns_) return 0;
+        uint64_t target = (now_ns - origin_ns_) / tick_ns_;
+        size_t fired = 0;
+        while (current_ <= target) {
+            if (size_ == 0) {
+                current_ = target + 1;  // nothing to run, skip idle ticks
+                break;
+            }
+            if ((current_ & MASK) == 0 && current_ != 0) cascade(1);
+            if (level_count_[0] == 0) {
+                // lower levels are empty, nothing can fire before the next cascade of the lowest busy level
+                int level = 1;
+                while (level < LEVELS - 1 && level_count_[level] == 0) ++level;
+                uint64_t span = 1ULL << (level * SLOT_BITS);
+                current_ = std::min((current_ | (span - 1)) + 1, target + 1);
+                continue;
+            }
+            detach(slot_head(0, current_));
+            // timers added by callbacks from here on land in the next tick at the earliest
+            ++current_;
+            fired += fire(fn);
+        }
+        return fired;
+    }
+
+    size_t advance(uint64_t now_ns) {
+        return advance(now_ns, [](TimerId, TPayload &p) { p(); });
+    }
+
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    uint64_t tick_ns() const noexcept { return tick_ns_; }
+
+    /**
+     * time of the next tick advance() will process
+     */
+    uint64_t next_tick_ns() const noexcept { return origin_ns_ + current_ * tick_ns_; }
+
+private:
+    static uint32_t slot_head(int level, uint64_t tick) noexcept {
+        return static_cast<uint32_t>(level) * SLOTS + static_cast<uint32_t>((tick >> (level * SLOT_BITS)) & MASK);
+    }
+
+    bool valid(TimerId id) const noexcept {
+        uint32_t idx = static_cast<uint32_t>(id);
+        uint32_t gen = static_cast<uint32_t>(id >> 32);
+        return idx >= SENTINELS && idx < nodes_.size() && nodes_[idx].active && nodes_[idx].gen == gen;
+    }
+
+    TimerId schedule_tick(uint64_t tick, TPayload &&payload) {
+        uint32_t idx;
+        if (free_ != NIL) {
+            idx = free_;
+            free_ = nodes_[idx].next;
+        } else {
+            if (nodes_.size() >= UINT32_MAX - 1) throw std::length_error("TimingWheel: too many timers");
+            idx = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+        Node &n = nodes_[idx];
+        n.active = true;
+        n.expire = tick < current_ ? current_ : tick;
+        n.payload = std::move(payload);
+        insert(idx);
+        ++size_;
+        return (static_cast<uint64_t>(n.gen) << 32) | idx;
+    }
+
+    void insert(uint32_t idx) {
+        uint64_t expire = nodes_[idx].expire;
+        uint64_t delta = expire - current_;
+        int level = 0;
+        while (level < LEVELS - 1 && delta >= (1ULL << ((level + 1) * SLOT_BITS))) ++level;
+        if (level == LEVELS - 1 && delta >= (1ULL << (LEVELS * SLOT_BITS))) {
+            expire = current_ + (1ULL << (LEVELS * SLOT_BITS)) - 1;  // park in the farthest slot
+        }
+        nodes_[idx].level = static_cast<uint8_t>(level);
+        ++level_count_[level];
+        link(slot_head(level, expire), idx);
+    }
+
+    void link(uint32_t head, uint32_t idx) {
+        Node &h = nodes_[head];
+        Node &n = nodes_[idx];
+        n.prev = h.prev;
+        n.next = head;
+        nodes_[h.prev].next = idx;
+        h.prev = idx;
+    }
+
+    void unlink(uint32_t idx) {
+        Node &n = nodes_[idx];
+        --level_count_[n.level];
+        nodes_[n.prev].next = n.next;
+        nodes_[n.next].prev = n.prev;
+        n.prev = n.next = NIL;
+    }
+
+    void release(uint32_t idx) {
+        Node &n = nodes_[idx];
+        n.active = false;
+        n.payload = TPayload{};
+        if (++n.gen == 0) n.gen = 1;
+        n.next = free_;
+        free_ = idx;
+        --size_;
+    }
+
+    /**
+     * move the slot of level that current_ just entered down to lower levels
+     */
+    void cascade(int level) {
+        if (level >= LEVELS) return;
+        uint64_t idx_in_level = (current_ >> (level * SLOT_BITS)) & MASK;
+        if (idx_in_level == 0) cascade(level + 1);
+        uint32_t head = slot_head(level, current_);
+        while (nodes_[head].next != head) {
+            uint32_t idx = nodes_[head].next;
+            unlink(idx);
+            insert(idx);
+        }
+    }
+
+    /**
+     * move a whole slot to the expiring list
+     */
+    void detach(uint32_t head) {
+        if (nodes_[head].next == head) return;
+        Node &h = nodes_[head];
+        Node &e = nodes_[EXPIRING];
+        e.next = h.next;
+        e.prev = h.prev;
+        nodes_[h.next].prev = EXPIRING;
+        nodes_[h.prev].next = EXPIRING;
+        h.next = h.prev = head;
+    }
+
+    template <typename F>
+    size_t fire(F &fn) {
+        size_t fired = 0;
+        while (nodes_[EXPIRING].next != EXPIRING) {
+            uint32_t idx = nodes_[EXPIRING].next;
+            unlink(idx);
+            TimerId id = (static_cast<uint64_t>(nodes_[idx].gen) << 32) | idx;
+            // take the payload out, the callback may grow nodes_ or cancel this id
+            TPayload payload = std::move(nodes_[idx].payload);
+            release(idx);
+            fn(id, payload);
+            ++fired;
+        }
+        return fired;
+    }
+
+    std::vector<Node> nodes_;
+    uint32_t free_{NIL};
+    size_t size_{0};
+    size_t level_count_[LEVELS]{};  // linked timers per level, the expiring list still counts as level 0
+    uint64_t current_{0};  // next tick to process
+    const uint64_t tick_ns_;
+    const uint64_t origin_ns_;
+};
+
+using TimingWheel = TimingWheelT<SboTask>;
+
+inline uint64_t monotonic_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * drives a wheel built on monotonic_ns() with a single periodic timerfd, add fd() to epoll and call
+ * on_readable() when it fires. A busy-poll loop can skip the fd and call wheel.advance(monotonic_ns())
+ */
+template <typename TWheel>
+class TimerFdDriver {
+public:
+    explicit TimerFdDriver(TWheel &wheel) : wheel_(wheel) {
+        fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (fd_ < 0) throw std::runtime_error("timerfd_create failed");
+        uint64_t tick = wheel_.tick_ns();
+        struct itimerspec spec {};
+        spec.it_interval.tv_sec = static_cast<time_t>(tick / 1000000000ULL);
+        spec.it_interval.tv_nsec = static_cast<long>(tick % 1000000000ULL);
+        spec.it_value = spec.it_interval;
+        if (timerfd_settime(fd_, 0, &spec, nullptr) < 0) {
+            close(fd_);
+            throw std::runtime_error("timerfd_settime failed");
+        }
+    }
+
+    ~TimerFdDriver() { close(fd_); }
+
+    TimerFdDriver(const TimerFdDriver &) = delete;
+    TimerFdDriver &operator=(const TimerFdDriver &) = delete;
+
+    int fd() const noexcept { return fd_; }
+
+    /**
+     * @return number of fired timers
+     */
+    size_t on_readable() {
+        uint64_t expirations;
+        while (read(fd_, &expirations, sizeof(expirations)) > 0) {
+        }
+        return wheel_.advance(monotonic_ns());
+    }
+
+private:
+    TWheel &wheel_;
+    int fd_{-1};
+};
+}  // namespace zerg
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <zerg/tool/coro.h>
+
+#ifdef ZERG_HAS_COROUTINES
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <zerg/io/input_data.h>
+
+namespace zerg {
+/**
+ * awaitable versions of the blocking loaders, the file is read on a worker of pool
+ * co_await many of them through when_all() to load files concurrently, pool.size() at a time
+ */
+template <typename TPool>
+Task<std::shared_ptr<DayData>> async_load_feather_data(TPool& pool, std::string input_file, std::string x_pattern = "",
+                                                       std::unordered_map<std::string, bool> x_names = {},
+                                                       bool metaOnly = false, bool print = true) {
+  co_return co_await async_run(pool, [&] { return load_feather_data(input_file, x_pattern, x_names, metaOnly, print); });
+}
+
+template <typename TPool>
+Task<std::shared_ptr<DayData>> async_load_csv_data(TPool& pool, std::string input_file, std::string x_pattern = "",
+                                                   std::unordered_map<std::string, bool> x_names = {},
+                                                   bool metaOnly = false, bool print = true) {
+  co_return co_await async_run(pool, [&] { return load_csv_data(input_file, x_pattern, x_names, metaOnly, print); });
+}
+}  // namespace zerg
+#endif
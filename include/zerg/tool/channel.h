@@ -1,9 +1,13 @@
 #pragma once
 
 #include <pthread.h>
+#include <cstdint>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <zerg/io/shm.h>
+#include <zerg/log.h>
+#include <zerg/tool/wait_strategy.h>
 
 using namespace std;
 
@@ -52,6 +56,54 @@ struct Channel {
     const char* PollVar(const char* data);
     int64_t GetIndex();
     int32_t GetMaxCount();
+    /**
+     * wait with TWait (see wait_strategy.h) until index moves beyond doneIndex, return the latest index
+     * publisher lives in another process, so strategies relying on notify fall back to their own timeout
+     */
+    template <typename TWait>
+    int64_t WaitIndex(int64_t doneIndex, TWait& waiter) {
+        int64_t curIndex = doneIndex;
+        waiter.wait([&] {
+            curIndex = __atomic_load_n(&pcb->curr_idx, __ATOMIC_ACQUIRE);
+            return curIndex != doneIndex;
+        });
+        return curIndex;
+    }
+};
+
+/**
+ * read position of one subscriber in a variable length channel, follows warp and a cleared channel
+ */
+struct VarChannelCursor {
+    int64_t done{-1};  // seq of the last message handed out
+    const char* data{nullptr};
+
+    /**
+     * fn(const ShmMsgHeader*) for each message published since the last call, at most max of them
+     * @return number of messages consumed
+     * @throw std::runtime_error if the next message can not be located (channel full without warp),
+     * polling again would only hit the same spot
+     */
+    template <typename F>
+    size_t Poll(Channel* ch, F&& fn, size_t max = SIZE_MAX) {
+        int64_t cur = __atomic_load_n(&ch->pcb->curr_idx, __ATOMIC_ACQUIRE);
+        if (cur < done) {
+            ZLOG("%ld < %ld, channel %s maybe cleared", cur, done, ch->name.c_str());
+            done = cur;
+            data = nullptr;
+        }
+        size_t n = 0;
+        for (int64_t i = done + 1; i <= cur && n < max; ++i, ++n) {
+            const char* pd = ch->PollVar(data);
+            if (pd == nullptr) ZLOG_THROW("%s can not read message %ld of %ld", ch->name.c_str(), i, cur);
+            auto* h = reinterpret_cast<const ShmMsgHeader*>(pd);
+            if (h->seq_num != i) i = h->seq_num;  // channel warp
+            fn(h);
+            data = pd + h->msg_len;
+            done = i;
+        }
+        return n;
+    }
 };
 
 struct ChannelMgr {
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <zerg/log.h>
+#include <zerg/tool/channel.h>
+#include <zerg/tool/event_bus.h>
+
+namespace zerg {
+/**
+ * consumer of a variable length Channel, walks the new messages and calls the handler registered for
+ * ShmMsgHeader.msg_type, the table is a vector indexed by msg_type so dispatch is one bounds check and a call
+ *
+ *   ChannelDispatcher d(mgr.RegisterSubscriber("md"));
+ *   d.on<Tick>(1, [&](const Tick& t, const ShmMsgHeader& h) { ... });
+ *   d.on<Trade>(2, [&](const Trade& t) { ... });
+ *   while (running) d.wait_poll(waiter);
+ *
+ * handlers get a const T& straight into shm, no copy, only valid during the call. the payload starts right after
+ * the 16 bytes header, it is aligned as long as publishers keep msg_len a multiple of alignof(T).
+ * in an EventLoop: loop.add_poller("md", 0, [&d](size_t max) { return d.poll(max); });
+ * not thread safe, one dispatcher per consuming thread
+ */
+class ChannelDispatcher {
+  public:
+  using RawHandler = std::function<void(const ShmMsgHeader&)>;
+
+  struct Stats {
+    uint64_t dispatched{0};
+    uint64_t unhandled{0};  // no handler for msg_type, passed to the fallback if set
+    uint64_t malformed{0};  // msg_len shorter than the registered payload, dropped
+  };
+
+  explicit ChannelDispatcher(Channel* ch) : m_ch(ch) {
+    if (ch == nullptr) throw std::invalid_argument("null channel");
+    if (ch->pcb->topic_size != 0) ZLOG_THROW("%s is a fixed size channel", ch->name.c_str());
+  }
+
+  /**
+   * fn(const T&) or fn(const T&, const ShmMsgHeader&), replaces a previous handler of msg_type
+   */
+  template <typename T, typename F>
+  void on(uint16_t msg_type, F fn) {
+    static_assert(std::is_trivially_copyable<T>::value, "T is read in place from shm, must be trivially copyable");
+    auto& e = slot(msg_type);
+    e.min_len = sizeof(ShmMsgHeader) + sizeof(T);
+    e.fn = [fn = std::move(fn)](const ShmMsgHeader& h) {
+      const T& v = *reinterpret_cast<const T*>(&h + 1);
+      if constexpr (std::is_invocable<F&, const T&, const ShmMsgHeader&>::value) {
+        fn(v, h);
+      } else {
+        fn(v);
+      }
+    };
+  }
+
+  /**
+   * header only handler, for payloads with their own length such as strings or arrays
+   */
+  void on_raw(uint16_t msg_type, RawHandler fn) {
+    auto& e = slot(msg_type);
+    e.min_len = sizeof(ShmMsgHeader);
+    e.fn = std::move(fn);
+  }
+
+  /**
+   * fire msg_type on bus with std::function<void(const T&)>, subscribers of that event get the shm view
+   */
+  template <typename T>
+  void route_to(uint16_t msg_type, EventBus& bus) {
+    using CallbackType = std::function<void(const T&)>;
+    on<T>(msg_type, [&bus, msg_type](const T& v) { bus.fire_event<CallbackType>(msg_type, v); });
+  }
+
+  void off(uint16_t msg_type) {
+    if (msg_type < m_table.size()) m_table[msg_type] = Entry{};
+  }
+
+  /**
+   * called for every msg_type without a handler
+   */
+  void on_unhandled(RawHandler fn) { m_unhandled = std::move(fn); }
+
+  /**
+   * dispatch the messages published since the last call, at most max of them
+   * @return number of messages consumed
+   * @throw std::runtime_error if the channel can not be read, see VarChannelCursor
+   */
+  size_t poll(size_t max = std::numeric_limits<size_t>::max()) {
+    return m_cursor.Poll(m_ch, [this](const ShmMsgHeader* h) { dispatch(*h); }, max);
+  }
+
+  /**
+   * wait with TWait (see wait_strategy.h) for new messages, then poll()
+   */
+  template <typename TWait>
+  size_t wait_poll(TWait& waiter, size_t max = std::numeric_limits<size_t>::max()) {
+    m_ch->WaitIndex(m_cursor.done, waiter);
+    return poll(max);
+  }
+
+  /**
+   * call the handler of one message, for callers walking the channel themselves
+   */
+  void dispatch(const ShmMsgHeader& h) {
+    if (h.msg_type < m_table.size()) {
+      const Entry& e = m_table[h.msg_type];
+      if (e.fn) {
+        if (h.msg_len < e.min_len) {
+          ++m_stats.malformed;
+          return;
+        }
+        ++m_stats.dispatched;
+        e.fn(h);
+        return;
+      }
+    }
+    ++m_stats.unhandled;
+    if (m_unhandled) m_unhandled(h);
+  }
+
+  bool has_handler(uint16_t msg_type) const noexcept {
+    return msg_type < m_table.size() && static_cast<bool>(m_table[msg_type].fn);
+  }
+
+  const Stats& stats() const noexcept { return m_stats; }
+  int64_t index() const noexcept { return m_cursor.done; }
+  Channel* channel() const noexcept { return m_ch; }
+
+  private:
+  struct Entry {
+    uint32_t min_len{0};
+    RawHandler fn;
+  };
+
+  Entry& slot(uint16_t msg_type) {
+    if (msg_type >= m_table.size()) m_table.resize(static_cast<size_t>(msg_type) + 1);
+    return m_table[msg_type];
+  }
+
+  Channel* m_ch;
+  VarChannelCursor m_cursor;
+  std::vector<Entry> m_table;
+  RawHandler m_unhandled;
+  Stats m_stats;
+};
+}  // namespace zerg
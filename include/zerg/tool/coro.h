@@ -0,0 +1,385 @@
+#pragma once
+
+/**
+ * C++20 coroutines on top of the thread pools, only with -std=c++20 (cmake -DZERG_CXX20=ON)
+ * under C++17 this header is empty and ZERG_HAS_COROUTINES is not defined
+ *
+ *   Task<std::shared_ptr<DayData>> load(ThreadPool& pool, std::string path) {
+ *     co_return co_await async_run(pool, [=] { return load_feather_data(path); });
+ *   }
+ *   std::vector<Task<std::shared_ptr<DayData>>> days;
+ *   for (auto& p : paths) days.push_back(load(pool, p));
+ *   auto loaded = sync_wait(when_all(std::move(days)));  // pool.size() files at a time, no thread per file
+ *
+ * Task is lazy, it starts when awaited and resumes its awaiter on the thread it finished on
+ */
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define ZERG_HAS_COROUTINES 1
+
+namespace zerg {
+template <typename T = void>
+class Task;
+
+namespace detail {
+struct FinalAwaiter {
+  bool await_ready() const noexcept { return false; }
+  template <typename P>
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+    auto next = h.promise().continuation;
+    return next ? next : std::noop_coroutine();
+  }
+  void await_resume() const noexcept {}
+};
+
+struct PromiseBase {
+  std::coroutine_handle<> continuation;
+  std::exception_ptr error;
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() noexcept { error = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+  std::optional<T> value;
+
+  Task<T> get_return_object() noexcept;
+  template <typename U>
+  void return_value(U&& v) {
+    value.emplace(std::forward<U>(v));
+  }
+  T take() {
+    if (error) std::rethrow_exception(error);
+    return std::move(*value);
+  }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+  Task<void> get_return_object() noexcept;
+  void return_void() const noexcept {}
+  void take() {
+    if (error) std::rethrow_exception(error);
+  }
+};
+}  // namespace detail
+
+template <typename T>
+class [[nodiscard]] Task {
+  public:
+  using promise_type = detail::Promise<T>;
+  using value_type = T;
+
+  Task() noexcept = default;
+  explicit Task(std::coroutine_handle<promise_type> h) noexcept : m_handle(h) {}
+  Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      if (m_handle) m_handle.destroy();
+      m_handle = std::exchange(other.m_handle, nullptr);
+    }
+    return *this;
+  }
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+  ~Task() {
+    if (m_handle) m_handle.destroy();
+  }
+
+  bool valid() const noexcept { return static_cast<bool>(m_handle); }
+
+  auto operator co_await() && noexcept { return Awaiter{m_handle}; }
+  auto operator co_await() & noexcept { return Awaiter{m_handle}; }
+
+  private:
+  struct Awaiter {
+    std::coroutine_handle<promise_type> handle;
+    bool await_ready() const noexcept { return !handle || handle.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+      handle.promise().continuation = awaiting;
+      return handle;  // symmetric transfer, starts the task without growing the stack
+    }
+    T await_resume() {
+      if (!handle) throw std::logic_error("await on an empty Task");
+      return handle.promise().take();
+    }
+  };
+
+  std::coroutine_handle<promise_type> m_handle;
+};
+
+namespace detail {
+template <typename T>
+Task<T> Promise<T>::get_return_object() noexcept {
+  return Task<T>{std::coroutine_handle<Promise<T>>::from_promise(*this)};
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept {
+  return Task<void>{std::coroutine_handle<Promise<void>>::from_promise(*this)};
+}
+
+/**
+ * eager coroutine that frees itself when done, drives sync_wait and when_all
+ */
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() const noexcept { return {}; }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+};
+
+template <typename T>
+Detached sync_wait_body(Task<T>& task, std::promise<void>& done, std::optional<T>& out, std::exception_ptr& error) {
+  try {
+    out.emplace(co_await task);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  done.set_value();  // a promise may die right after, unlike a Latch
+}
+
+inline Detached sync_wait_body(Task<void>& task, std::promise<void>& done, std::exception_ptr& error) {
+  try {
+    co_await task;
+  } catch (...) {
+    error = std::current_exception();
+  }
+  done.set_value();
+}
+}  // namespace detail
+
+/**
+ * run task to completion, blocking the calling thread
+ */
+template <typename T>
+T sync_wait(Task<T> task) {
+  std::promise<void> done;
+  auto finished = done.get_future();
+  std::exception_ptr error;
+  if constexpr (std::is_void_v<T>) {
+    detail::sync_wait_body(task, done, error);
+    finished.wait();
+    if (error) std::rethrow_exception(error);
+  } else {
+    std::optional<T> out;
+    detail::sync_wait_body(task, done, out, error);
+    finished.wait();
+    if (error) std::rethrow_exception(error);
+    return std::move(*out);
+  }
+}
+
+/**
+ * co_await schedule_on(pool) continues the coroutine on a worker of pool (ThreadPool, WorkStealingPool)
+ */
+template <typename TPool>
+auto schedule_on(TPool& pool) {
+  struct Awaiter {
+    TPool& pool;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) { pool.enqueue([h] { h.resume(); }); }
+    void await_resume() const noexcept {}
+  };
+  return Awaiter{pool};
+}
+
+/**
+ * fn() on a pool worker, the awaiting coroutine continues there, wraps blocking calls (file loading)
+ */
+template <typename TPool, typename F>
+Task<std::invoke_result_t<F>> async_run(TPool& pool, F fn) {
+  co_await schedule_on(pool);
+  co_return fn();
+}
+
+namespace detail {
+struct WhenAllState {
+  std::atomic<size_t> remaining;
+  std::coroutine_handle<> continuation;
+  std::mutex mutex;
+  std::exception_ptr error;
+
+  explicit WhenAllState(size_t n) : remaining(n + 1) {}  // +1 for the awaiter itself
+
+  void finish_one() {
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) continuation.resume();
+  }
+};
+
+template <typename T, typename TOut>
+Detached when_all_item(Task<T>& task, WhenAllState& state, TOut* out) {
+  try {
+    if constexpr (std::is_void_v<T>) {
+      co_await task;
+    } else {
+      out->emplace(co_await task);
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.error) state.error = std::current_exception();
+  }
+  state.finish_one();
+}
+
+template <typename T, typename TOut>
+auto when_all_awaiter(std::vector<Task<T>>& tasks, std::vector<TOut>& outs, WhenAllState& state) {
+  struct Awaiter {
+    std::vector<Task<T>>& tasks;
+    std::vector<TOut>& outs;
+    WhenAllState& state;
+    bool await_ready() const noexcept { return tasks.empty(); }
+    bool await_suspend(std::coroutine_handle<> h) {
+      state.continuation = h;
+      for (size_t i = 0; i < tasks.size(); ++i) when_all_item(tasks[i], state, outs.empty() ? nullptr : &outs[i]);
+      // the last finished task resumes h, unless everything finished inline
+      return state.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+    void await_resume() const noexcept {}
+  };
+  return Awaiter{tasks, outs, state};
+}
+}  // namespace detail
+
+/**
+ * runs all tasks concurrently, results in input order, the first exception is rethrown after all finished
+ */
+template <typename T>
+Task<std::vector<T>> when_all(std::vector<Task<T>> tasks) {
+  detail::WhenAllState state(tasks.size());
+  std::vector<std::optional<T>> outs(tasks.size());
+  co_await detail::when_all_awaiter(tasks, outs, state);
+  if (state.error) std::rethrow_exception(state.error);
+  std::vector<T> ret;
+  ret.reserve(outs.size());
+  for (auto& o : outs) ret.push_back(std::move(*o));
+  co_return ret;
+}
+
+inline Task<void> when_all(std::vector<Task<void>> tasks) {
+  detail::WhenAllState state(tasks.size());
+  std::vector<std::optional<int>> outs;  // unused
+  co_await detail::when_all_awaiter(tasks, outs, state);
+  if (state.error) std::rethrow_exception(state.error);
+}
+
+/**
+ * one thread waiting on epoll for many fds, co_await poller.readable(fd) resumes the coroutine on that
+ * thread once fd is readable, keep the work there short or schedule_on(pool) after it
+ */
+class FdPoller {
+  public:
+  FdPoller() {
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epoll < 0 || m_wake < 0) throw std::runtime_error("FdPoller: epoll/eventfd failed");
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = m_wake;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &ev);
+    m_thread = std::thread([this] { loop(); });
+  }
+
+  ~FdPoller() {
+    m_stop.store(true, std::memory_order_release);
+    uint64_t one = 1;
+    ssize_t ret = write(m_wake, &one, sizeof(one));
+    (void)ret;
+    m_thread.join();
+    close(m_wake);
+    close(m_epoll);
+  }
+
+  FdPoller(const FdPoller&) = delete;
+  FdPoller& operator=(const FdPoller&) = delete;
+
+  /**
+   * one waiter per fd at a time
+   */
+  auto readable(int fd) { return Awaiter{*this, fd, EPOLLIN}; }
+  auto writable(int fd) { return Awaiter{*this, fd, EPOLLOUT}; }
+
+  private:
+  struct Awaiter {
+    FdPoller& poller;
+    int fd;
+    uint32_t events;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) { poller.arm(fd, events, h); }
+    void await_resume() const noexcept {}
+  };
+
+  void arm(int fd, uint32_t events, std::coroutine_handle<> h) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_waiters[fd] = h;
+    }
+    epoll_event ev{};
+    ev.events = events | EPOLLONESHOT;
+    ev.data.fd = fd;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &ev) < 0 && errno == ENOENT) epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev);
+  }
+
+  void loop() {
+    epoll_event events[64];
+    while (!m_stop.load(std::memory_order_acquire)) {
+      int n = epoll_wait(m_epoll, events, 64, -1);
+      for (int i = 0; i < n; ++i) {
+        int fd = events[i].data.fd;
+        if (fd == m_wake) continue;
+        std::coroutine_handle<> h;
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          auto it = m_waiters.find(fd);
+          if (it == m_waiters.end()) continue;
+          h = it->second;
+          m_waiters.erase(it);
+        }
+        h.resume();
+      }
+    }
+  }
+
+  int m_epoll{-1};
+  int m_wake{-1};
+  std::atomic<bool> m_stop{false};
+  std::mutex m_mutex;
+  std::unordered_map<int, std::coroutine_handle<>> m_waiters;
+  std::thread m_thread;
+};
+
+/**
+ * read from a non blocking fd (socket, pipe), suspends while it would block
+ * @return bytes read, 0 at end of stream, -1 with errno on error
+ */
+inline Task<ssize_t> async_read(FdPoller& poller, int fd, void* buf, size_t len) {
+  while (true) {
+    ssize_t n = ::read(fd, buf, len);
+    if (n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) co_return n;
+    if (errno != EINTR) co_await poller.readable(fd);
+  }
+}
+}  // namespace zerg
+
+#endif
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace zerg {
+/**
+ * epoch based memory reclamation for lock-free structures
+ * every thread registers once and gets a Handle, readers wrap access in an EpochGuard,
+ * writers retire unlinked objects instead of deleting them. An object retired in epoch e is freed
+ * once the global epoch reached e + 2, by then no reader can still see it. Reclaim is batched and
+ * never waits for readers, a slow reader only delays freeing.
+ *
+ *   auto* h = domain.register_thread();
+ *   { EpochGuard g(*h); Node* n = head.load(); ... }       // read side
+ *   Node* old = head.exchange(fresh); h->retire(old);      // write side
+ *   domain.unregister_thread(h);
+ */
+class EpochDomain {
+  public:
+  static constexpr size_t RECLAIM_BATCH = 64;
+
+  class Handle {
+    public:
+    void enter() noexcept {
+      if (m_nest++ > 0) return;
+      uint64_t e = m_domain->m_epoch.load(std::memory_order_relaxed);
+      m_state.store((e << 1) | 1, std::memory_order_relaxed);
+      // announce before any shared read
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void exit() noexcept {
+      if (--m_nest > 0) return;
+      m_state.store(m_state.load(std::memory_order_relaxed) & ~uint64_t(1), std::memory_order_release);
+    }
+
+    bool in_critical() const noexcept { return m_nest > 0; }
+
+    void retire(void* p, void (*deleter)(void*)) {
+      m_retired.push_back({p, deleter, m_domain->m_epoch.load(std::memory_order_seq_cst)});
+      if (m_retired.size() >= m_next_reclaim) {
+        reclaim();
+        // avoid scanning on every retire when readers hold the epoch back
+        m_next_reclaim = m_retired.size() + RECLAIM_BATCH;
+      }
+    }
+
+    template <typename T>
+    void retire(T* p) {
+      retire(static_cast<void*>(p), [](void* q) { delete static_cast<T*>(q); });
+    }
+
+    /**
+     * try to advance the global epoch and free whatever is old enough
+     * @return number of objects still waiting
+     */
+    size_t reclaim() {
+      m_domain->try_advance();
+      uint64_t safe = m_domain->m_epoch.load(std::memory_order_acquire);
+      size_t kept = 0;
+      for (auto& r : m_retired) {
+        if (r.epoch + 2 <= safe) {
+          r.deleter(r.ptr);
+        } else {
+          m_retired[kept++] = r;
+        }
+      }
+      m_retired.resize(kept);
+      return kept;
+    }
+
+    size_t pending() const noexcept { return m_retired.size(); }
+
+    private:
+    friend class EpochDomain;
+    struct Retired {
+      void* ptr;
+      void (*deleter)(void*);
+      uint64_t epoch;
+    };
+
+    explicit Handle(EpochDomain* domain) : m_domain(domain) {}
+
+    // (epoch << 1) | active, read by other threads
+    alignas(64) std::atomic<uint64_t> m_state{0};
+    std::atomic<bool> m_used{true};
+    Handle* m_next{nullptr};
+
+    // owner thread only
+    alignas(64) EpochDomain* m_domain;
+    uint32_t m_nest{0};
+    size_t m_next_reclaim{RECLAIM_BATCH};
+    std::vector<Retired> m_retired;
+  };
+
+  EpochDomain() = default;
+
+  ~EpochDomain() {
+    Handle* h = m_head.load();
+    while (h) {
+      Handle* next = h->m_next;
+      for (auto& r : h->m_retired) r.deleter(r.ptr);
+      delete h;
+      h = next;
+    }
+    for (auto& r : m_orphans) r.deleter(r.ptr);
+  }
+
+  EpochDomain(const EpochDomain&) = delete;
+  EpochDomain& operator=(const EpochDomain&) = delete;
+
+  /**
+   * reuse a released handle if possible, handles are owned by the domain
+   */
+  Handle* register_thread() {
+    for (Handle* h = m_head.load(std::memory_order_acquire); h; h = h->m_next) {
+      bool expected = false;
+      if (h->m_used.compare_exchange_strong(expected, true)) return h;
+    }
+    auto* h = new Handle(this);
+    Handle* head = m_head.load(std::memory_order_relaxed);
+    do {
+      h->m_next = head;
+    } while (!m_head.compare_exchange_weak(head, h, std::memory_order_release, std::memory_order_relaxed));
+    return h;
+  }
+
+  /**
+   * objects not yet reclaimed are handed to the domain
+   */
+  void unregister_thread(Handle* h) {
+    h->reclaim();
+    if (!h->m_retired.empty()) {
+      std::lock_guard<std::mutex> lock(m_orphan_mutex);
+      m_orphans.insert(m_orphans.end(), h->m_retired.begin(), h->m_retired.end());
+      h->m_retired.clear();
+    }
+    h->m_nest = 0;
+    h->m_state.store(0, std::memory_order_release);
+    h->m_used.store(false, std::memory_order_release);
+  }
+
+  /**
+   * free orphans of unregistered threads
+   * @return number of orphans still waiting
+   */
+  size_t reclaim_orphans() {
+    try_advance();
+    uint64_t safe = m_epoch.load(std::memory_order_acquire);
+    std::lock_guard<std::mutex> lock(m_orphan_mutex);
+    size_t kept = 0;
+    for (auto& r : m_orphans) {
+      if (r.epoch + 2 <= safe) {
+        r.deleter(r.ptr);
+      } else {
+        m_orphans[kept++] = r;
+      }
+    }
+    m_orphans.resize(kept);
+    return kept;
+  }
+
+  uint64_t epoch() const noexcept { return m_epoch.load(std::memory_order_acquire); }
+
+  /**
+   * advance only if every active reader already observed current epoch
+   */
+  bool try_advance() noexcept {
+    uint64_t e = m_epoch.load(std::memory_order_seq_cst);
+    for (Handle* h = m_head.load(std::memory_order_acquire); h; h = h->m_next) {
+      uint64_t s = h->m_state.load(std::memory_order_seq_cst);
+      if ((s & 1) && (s >> 1) != e) return false;
+    }
+    return m_epoch.compare_exchange_strong(e, e + 1, std::memory_order_seq_cst);
+  }
+
+  private:
+  alignas(64) std::atomic<uint64_t> m_epoch{0};
+  std::atomic<Handle*> m_head{nullptr};
+  std::mutex m_orphan_mutex;
+  std::vector<Handle::Retired> m_orphans;
+};
+
+struct EpochGuard {
+  explicit EpochGuard(EpochDomain::Handle& h) : m_handle(h) { m_handle.enter(); }
+  ~EpochGuard() { m_handle.exit(); }
+  EpochGuard(const EpochGuard&) = delete;
+  EpochGuard& operator=(const EpochGuard&) = delete;
+
+  EpochDomain::Handle& m_handle;
+};
+}  // namespace zerg
@@ -1,8 +1,28 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <algorithm>
 #include <any>
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <typeindex>
 #include <unordered_map>
 #include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <zerg/algo/SpscQueue.h>
+#include <zerg/log.h>
+#include <zerg/tool/histogram.h>
+#include <zerg/tool/wait_strategy.h>
+#include <zerg/unix.h>
 
 namespace zerg {
 template <typename T>
@@ -30,6 +50,150 @@ auto make_callback(T* instance, MemberFunc member_func) {
   });
 }
 
+/**
+ * what an async subscriber does with an event when its queue is full
+ * DropNewest  drop the event, the publisher never waits
+ * Block       publisher waits for space, use when every event matters more than publisher latency
+ * Disconnect  stop delivering to this subscriber at the first overflow, it is too slow to be useful
+ */
+enum class OverflowPolicy { DropNewest, Block, Disconnect };
+
+struct AsyncSubscriberOptions {
+  std::string name;
+  size_t capacity{4096};
+  OverflowPolicy overflow{OverflowPolicy::DropNewest};
+  int core{-1};  // pin the subscriber thread, -1 floats, subscribe_async throws if the process may not use it
+};
+
+struct AsyncSubscriberStats {
+  std::string name;
+  int32_t event_type{0};
+  uint64_t published{0};  // offered to the queue
+  uint64_t delivered{0};  // callback returned
+  uint64_t dropped{0};
+  size_t depth{0};  // queued now
+  bool disconnected{false};
+  Histogram::Snapshot lag;  // ns from fire_event to the start of the callback
+};
+
+namespace detail {
+template <typename CallbackType>
+struct callback_args;
+
+template <typename R, typename... Args>
+struct callback_args<std::function<R(Args...)>> {
+  using tuple = std::tuple<std::decay_t<Args>...>;
+};
+
+class AsyncLaneBase {
+  public:
+  virtual ~AsyncLaneBase() = default;
+  virtual AsyncSubscriberStats stats() const = 0;
+};
+
+/**
+ * one subscriber thread fed by an SPSC queue, the publisher thread is the only producer
+ */
+template <typename CallbackType>
+class AsyncLane : public AsyncLaneBase {
+  public:
+  using Args = typename callback_args<CallbackType>::tuple;
+
+  AsyncLane(int32_t event_type, CallbackType callback, AsyncSubscriberOptions opt)
+      : m_event_type(event_type), m_callback(std::move(callback)), m_opt(std::move(opt)),
+        m_queue(std::max<size_t>(2, m_opt.capacity + 1)) {
+    if (m_opt.core >= 0) {
+      auto allowed = GetAffinity();
+      if (std::find(allowed.begin(), allowed.end(), static_cast<size_t>(m_opt.core)) == allowed.end()) {
+        throw std::invalid_argument(m_opt.name + ": cpu " + std::to_string(m_opt.core) +
+                                    " is not in the process affinity");
+      }
+    }
+    m_thread = std::thread([this] { run(); });
+    if (m_opt.core >= 0) {
+      // pinned from here, a failure can not take the process down from inside the thread
+      cpu_set_t mask;
+      CPU_ZERO(&mask);
+      CPU_SET(m_opt.core, &mask);
+      int err = pthread_setaffinity_np(m_thread.native_handle(), sizeof(mask), &mask);
+      if (err != 0) ZLOG("WARN, %s not pinned to cpu %d: %s", m_opt.name.c_str(), m_opt.core, strerror(err));
+    }
+  }
+
+  ~AsyncLane() override {
+    m_queue.emplace(Item{std::nullopt, 0});  // stop marker, behind every queued event
+    m_thread.join();
+  }
+
+  template <typename... A>
+  void publish(A&&... args) {
+    ++m_published;
+    if (m_disconnected.load(std::memory_order_relaxed)) {
+      ++m_dropped;
+      return;
+    }
+    Item item{Args(std::forward<A>(args)...), now_ns()};
+    if (m_opt.overflow == OverflowPolicy::Block) {
+      m_queue.emplace(std::move(item));
+    } else if (!m_queue.try_emplace(std::move(item))) {
+      ++m_dropped;
+      if (m_opt.overflow == OverflowPolicy::Disconnect) m_disconnected.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  AsyncSubscriberStats stats() const override {
+    AsyncSubscriberStats s;
+    s.name = m_opt.name;
+    s.event_type = m_event_type;
+    s.published = m_published.load(std::memory_order_relaxed);
+    s.delivered = m_delivered.load(std::memory_order_acquire);
+    s.dropped = m_dropped.load(std::memory_order_relaxed);
+    s.depth = m_queue.size();
+    s.disconnected = m_disconnected.load(std::memory_order_relaxed);
+    s.lag = m_lag.snapshot();
+    return s;
+  }
+
+  private:
+  struct Item {
+    std::optional<Args> args;  // empty: stop
+    uint64_t publish_ns;
+  };
+
+  static uint64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+  }
+
+  void run() {
+    while (true) {
+      Item* item = m_queue.wait_front();
+      if (!item->args) {
+        m_queue.pop();
+        return;
+      }
+      m_lag.record(now_ns() - item->publish_ns);
+      std::apply(m_callback, *item->args);
+      m_queue.pop();
+      m_delivered.fetch_add(1, std::memory_order_release);  // callback effects visible to whoever sees the count
+    }
+  }
+
+  const int32_t m_event_type;
+  CallbackType m_callback;
+  const AsyncSubscriberOptions m_opt;
+  SpscQueue<Item, SpinFutexWait> m_queue;
+  // written by the publisher only, atomics so stats() can read them from anywhere
+  std::atomic<uint64_t> m_published{0};
+  std::atomic<uint64_t> m_dropped{0};
+  std::atomic<bool> m_disconnected{false};
+  std::atomic<uint64_t> m_delivered{0};
+  Histogram m_lag;
+  std::thread m_thread;
+};
+}  // namespace detail
+
 class EventBus {
   public:
   EventBus() = default;
@@ -37,18 +201,39 @@ class EventBus {
 
   template <typename CallbackType>
   void subscribe(int32_t event_type, CallbackType callback) {
-    auto type_it = m_cb_infos.find(event_type);
-    if (type_it == m_cb_infos.end()) {
-      m_cb_infos.insert({event_type, std::type_index(typeid(CallbackType))});
-    } else {
-      if (type_it->second != std::type_index(typeid(CallbackType))) {
-        throw std::runtime_error("Expected same signature for " + std::to_string(event_type));
-      }
-    }
+    check_signature<CallbackType>(event_type);
+    m_cb_infos.insert({event_type, std::type_index(typeid(CallbackType))});
     auto& callback_list = get_all_callbacks<CallbackType>(event_type);
     callback_list.push_back(callback);
   }
 
+  /**
+   * callback runs on its own thread, fire_event only copies the arguments into the subscriber queue
+   * arguments are stored decayed: references become copies (writes through an int& are not seen by the
+   * publisher) and pointers are copied as pointers, so what they point to must outlive the delivery.
+   * every bus publishing async events must be fired from a single thread
+   * @throw std::invalid_argument if opt.core is not in the process affinity, nothing is subscribed
+   * @throw std::runtime_error like subscribe() on a signature mismatch, before the subscriber thread starts
+   */
+  template <typename CallbackType>
+  void subscribe_async(int32_t event_type, CallbackType callback, AsyncSubscriberOptions opt = {}) {
+    check_signature<CallbackType>(event_type);
+    if (opt.name.empty()) opt.name = "async-" + std::to_string(event_type) + "-" + std::to_string(m_lanes.size());
+    auto lane = std::make_unique<detail::AsyncLane<CallbackType>>(event_type, std::move(callback), std::move(opt));
+    auto* raw = lane.get();
+    m_lanes.push_back(std::move(lane));
+    subscribe(event_type, CallbackType([raw](auto&&... args) { raw->publish(std::forward<decltype(args)>(args)...); }));
+  }
+
+  /**
+   * queue depth, drops and delivery lag of every async subscriber
+   */
+  std::vector<AsyncSubscriberStats> async_stats() const {
+    std::vector<AsyncSubscriberStats> ret;
+    for (auto& lane : m_lanes) ret.push_back(lane->stats());
+    return ret;
+  }
+
   template <typename CallbackType>
   std::vector<CallbackType>& get_all_callbacks(int32_t event_type) {
     if (m_cbs.find(event_type) == m_cbs.end()) {
@@ -69,6 +254,16 @@ class EventBus {
   }
 
   private:
+  template <typename CallbackType>
+  void check_signature(int32_t event_type) const {
+    auto type_it = m_cb_infos.find(event_type);
+    if (type_it != m_cb_infos.end() && type_it->second != std::type_index(typeid(CallbackType))) {
+      throw std::runtime_error("Expected same signature for " + std::to_string(event_type));
+    }
+  }
+
+  // declared first so the lanes outlive the callbacks pointing at them
+  std::vector<std::unique_ptr<detail::AsyncLaneBase>> m_lanes;
   std::unordered_map<int32_t, std::any> m_cbs;
   std::unordered_map<int32_t, std::type_index> m_cb_infos;
 };
@@ -0,0 +1,400 @@
+#pragma once
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <zerg/algo/SpscQueue.h>
+#include <zerg/log.h>
+#include <zerg/tool/admin.h>
+#include <zerg/tool/channel.h>
+#include <zerg/tool/histogram.h>
+#include <zerg/tool/wait_strategy.h>
+#include <zerg/unix.h>
+
+namespace zerg {
+struct EventLoopConfig {
+  int core{-1};               // run() pins the calling thread here, -1 floats
+  bool busy_poll{true};       // false: block in epoll after idle_spins empty iterations
+  int idle_spins{1000};       // empty iterations before blocking
+  int idle_timeout_ms{1};     // max block, shm channels and queues can not wake epoll so they are re-polled after it
+  size_t batch{64};           // max items a source dispatches per iteration
+  int fd_poll_interval{16};   // non blocking iterations per epoll_wait, no epoll_wait at all without fd sources
+};
+
+/**
+ * single threaded event loop polling shm Channels, SpscQueues, the Admin slot, timers and fds
+ * every iteration polls the sources from the highest priority down, each dispatching at most batch items,
+ * so a flooded source delays but never starves the others. fds (sockets, timerfds) share one epoll set,
+ * polled with a zero timeout every fd_poll_interval iterations in busy mode, a loop over shm sources and queues
+ * alone makes no syscall. Blocking always waits in epoll, which also holds the stop() wake up. Callbacks run on the loop thread and may add sources or stop()
+ *
+ *   EventLoop loop({3, true});
+ *   loop.add_channel(md, [&](const char* rec) { on_tick(rec); }, 10, "md");
+ *   loop.add_admin(admin, [&](const std::string& cmd) { return handle(cmd); });
+ *   loop.add_timer_wheel(wheel);
+ *   loop.run();
+ *   ZLOG("%s", loop.report().c_str());
+ */
+class EventLoop {
+  public:
+  using SourceId = size_t;
+
+  struct SourceStat {
+    std::string name;
+    int priority{0};
+    uint64_t dispatched{0};  // items handed to the callback
+    uint64_t busy_polls{0};  // iterations in which the source had something
+  };
+
+  explicit EventLoop(EventLoopConfig config = EventLoopConfig()) : m_config(config) {
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epoll < 0 || m_wake < 0) throw std::runtime_error("EventLoop: epoll/eventfd failed");
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = WAKE_ID;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &ev);
+  }
+
+  ~EventLoop() {
+    close(m_wake);
+    close(m_epoll);
+  }
+
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  /**
+   * any source, poll() dispatches what is ready (at most max items) and returns how many
+   */
+  SourceId add_poller(std::string name, int priority, std::function<size_t(size_t max)> poll) {
+    auto s = std::make_unique<Source>();
+    s->name = std::move(name);
+    s->priority = priority;
+    s->poll = std::move(poll);
+    return add(std::move(s));
+  }
+
+  /**
+   * fixed size channel, fn(const char* record) for every record in the channel, from the first one like
+   * any other subscriber
+   */
+  SourceId add_channel(Channel* ch, std::function<void(const char*)> fn, int priority = 0, std::string name = "") {
+    int64_t done = -1;
+    return add_poller(name.empty() ? ch->name : name, priority, [ch, fn = std::move(fn), done](size_t max) mutable {
+      int64_t cur = __atomic_load_n(&ch->pcb->curr_idx, __ATOMIC_ACQUIRE);
+      if (cur < done) {
+        ZLOG("%ld < %ld, channel %s maybe cleared", cur, done, ch->name.c_str());
+        done = cur;
+      }
+      if (cur == done) return size_t(0);
+      int64_t last = std::min<int64_t>(cur, done + static_cast<int64_t>(max));
+      int64_t count = ch->GetMaxCount();
+      for (int64_t i = done + 1; i <= last; ++i) fn(ch->data_start + (i % count) * ch->pcb->topic_size);
+      size_t n = static_cast<size_t>(last - done);
+      done = last;
+      return n;
+    });
+  }
+
+  /**
+   * variable length channel, fn(const ShmMsgHeader*) with the payload following the header,
+   * see ChannelDispatcher for handlers by msg_type
+   * @throw std::runtime_error out of run() if the channel can not be read, see VarChannelCursor
+   */
+  SourceId add_channel_var(Channel* ch, std::function<void(const ShmMsgHeader*)> fn, int priority = 0,
+                           std::string name = "") {
+    return add_poller(name.empty() ? ch->name : name, priority,
+                      [ch, fn = std::move(fn), cursor = VarChannelCursor()](size_t max) mutable {
+      return cursor.Poll(ch, fn, max);
+    });
+  }
+
+  /**
+   * fn(T&) for every element, popped after fn returns
+   */
+  template <typename T, typename TWait>
+  SourceId add_queue(SpscQueue<T, TWait>& q, std::function<void(T&)> fn, int priority = 0, std::string name = "queue") {
+    return add_poller(std::move(name), priority, [&q, fn = std::move(fn)](size_t max) {
+      size_t n = 0;
+      for (T* p; n < max && (p = q.front()) != nullptr; ++n) {
+        fn(*p);
+        q.pop();
+      }
+      return n;
+    });
+  }
+
+  /**
+   * fn(cmd) for every new admin command, a non empty return is written back as the reply
+   */
+  SourceId add_admin(Admin& admin, std::function<std::string(const std::string&)> fn, int priority = -10) {
+    return add_poller("admin", priority, [&admin, fn = std::move(fn)](size_t) {
+      std::string cmd = admin.ReadCmd();
+      if (cmd.empty()) return size_t(0);
+      std::string ret = fn(cmd);
+      if (!ret.empty()) admin.WriteReturn(ret);
+      return size_t(1);
+    });
+  }
+
+  /**
+   * TimingWheel built on monotonic_ns(), advanced every iteration, a blocking loop wakes up for its next tick
+   */
+  template <typename TWheel>
+  SourceId add_timer_wheel(TWheel& wheel, int priority = 0, std::string name = "timers") {
+    SourceId id = add_poller(std::move(name), priority, [&wheel](size_t) {
+      timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      uint64_t now = static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+      return now < wheel.next_tick_ns() ? size_t(0) : wheel.advance(now);
+    });
+    m_by_id[id]->next_deadline = [&wheel] { return wheel.empty() ? UINT64_MAX : wheel.next_tick_ns(); };
+    return id;
+  }
+
+  /**
+   * readable fd (socket, pipe, eventfd), fn(fd) should read until EAGAIN, the fd is level triggered
+   */
+  SourceId add_fd(int fd, std::function<void(int)> fn, int priority = 0, std::string name = "fd") {
+    auto s = std::make_unique<Source>();
+    s->name = std::move(name);
+    s->priority = priority;
+    s->fd = fd;
+    s->on_fd = std::move(fn);
+    SourceId id = add(std::move(s));
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = id;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) < 0) throw std::runtime_error("EventLoop: epoll_ctl failed");
+    ++m_fd_sources;
+    m_fd_skipped = m_config.fd_poll_interval;  // the new fd is looked at in the next iteration
+    return id;
+  }
+
+  /**
+   * timerfd, fn(expirations since the last call)
+   */
+  SourceId add_timerfd(int fd, std::function<void(uint64_t)> fn, int priority = 0, std::string name = "timerfd") {
+    return add_fd(
+        fd,
+        [fn = std::move(fn)](int tfd) {
+          uint64_t expirations = 0;
+          if (read(tfd, &expirations, sizeof(expirations)) == sizeof(expirations)) fn(expirations);
+        },
+        priority, std::move(name));
+  }
+
+  /**
+   * a removed source is never polled again, its fd is taken out of epoll but not closed
+   */
+  void remove(SourceId id) {
+    if (id >= m_by_id.size() || m_by_id[id] == nullptr) return;
+    Source* s = m_by_id[id];
+    if (s->fd >= 0) {
+      epoll_ctl(m_epoll, EPOLL_CTL_DEL, s->fd, nullptr);
+      --m_fd_sources;
+    }
+    s->removed = true;
+    m_by_id[id] = nullptr;
+  }
+
+  /**
+   * pins to config.core and loops until stop(), a stop() before run() makes it return at once
+   */
+  void run() {
+    if (m_config.core >= 0) BindCore(static_cast<size_t>(m_config.core));
+    int idle = 0;
+    while (!m_stop.load(std::memory_order_acquire)) {
+      if (run_once(0) > 0) {
+        idle = 0;
+      } else if (!m_config.busy_poll && ++idle >= m_config.idle_spins) {
+        run_once(block_timeout_ms());
+        idle = 0;
+      } else {
+        cpu_relax();
+      }
+    }
+    m_stop.store(false, std::memory_order_relaxed);
+  }
+
+  /**
+   * one iteration, blocks in epoll up to timeout_ms when nothing was ready
+   * @return items dispatched
+   */
+  size_t run_once(int timeout_ms = 0) {
+    uint64_t start = now_ns();
+    size_t total = 0;
+    sort_sources();
+    for (size_t k = 0; k < m_sources.size(); ++k) {
+      Source& s = *m_sources[k];
+      if (s.removed || !s.poll) continue;
+      size_t n = s.poll(m_config.batch);
+      if (n > 0) {
+        s.dispatched += n;
+        ++s.busy_polls;
+        total += n;
+      }
+    }
+    if (total == 0 && timeout_ms != 0) {
+      total += poll_fds(timeout_ms);
+    } else if (m_fd_sources > 0 && ++m_fd_skipped >= m_config.fd_poll_interval) {
+      m_fd_skipped = 0;
+      total += poll_fds(0);
+    }
+    ++m_iterations;
+    if (total > 0) m_latency.record(now_ns() - start);
+    return total;
+  }
+
+  /**
+   * thread safe, also wakes a blocked loop
+   */
+  void stop() {
+    m_stop.store(true, std::memory_order_release);
+    uint64_t one = 1;
+    ssize_t ret = write(m_wake, &one, sizeof(one));
+    (void)ret;
+  }
+
+  std::vector<SourceStat> stats() const {
+    std::vector<SourceStat> ret;
+    for (auto* s : m_by_id) {
+      if (s) ret.push_back({s->name, s->priority, s->dispatched, s->busy_polls});
+    }
+    return ret;
+  }
+
+  /**
+   * duration of the iterations that dispatched something, in ns
+   */
+  Histogram::Snapshot latency() const noexcept { return m_latency.snapshot(); }
+
+  uint64_t iterations() const noexcept { return m_iterations; }
+
+  uint64_t fd_polls() const noexcept { return m_fd_polls; }  // epoll_wait calls
+
+  std::string report() const {
+    std::string out = "iterations " + std::to_string(m_iterations) + " fd polls " + std::to_string(m_fd_polls) +
+                      " busy " + m_latency.snapshot().to_string() + "\n";
+    char buf[160];
+    for (auto& s : stats()) {
+      snprintf(buf, sizeof(buf), "  %-16s prio %4d dispatched %10lu busy polls %10lu\n", s.name.c_str(), s.priority,
+               static_cast<unsigned long>(s.dispatched), static_cast<unsigned long>(s.busy_polls));
+      out += buf;
+    }
+    return out;
+  }
+
+  private:
+  static constexpr uint64_t WAKE_ID = UINT64_MAX;
+  static constexpr int MAX_EVENTS = 64;
+
+  struct Source {
+    std::string name;
+    int priority{0};
+    std::function<size_t(size_t)> poll;
+    std::function<uint64_t()> next_deadline;  // earliest time the source needs a poll, for blocking
+    int fd{-1};
+    std::function<void(int)> on_fd;
+    bool removed{false};
+    uint64_t dispatched{0};
+    uint64_t busy_polls{0};
+  };
+
+  static uint64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+  }
+
+  SourceId add(std::unique_ptr<Source> s) {
+    SourceId id = m_by_id.size();
+    m_by_id.push_back(s.get());
+    m_pending.push_back(std::move(s));
+    return id;
+  }
+
+  /**
+   * sources added by callbacks join at the start of the next iteration, removed ones are dropped there
+   */
+  void sort_sources() {
+    if (m_pending.empty() && std::none_of(m_sources.begin(), m_sources.end(), [](auto& s) { return s->removed; })) {
+      return;
+    }
+    m_sources.erase(std::remove_if(m_sources.begin(), m_sources.end(), [](auto& s) { return s->removed; }),
+                    m_sources.end());
+    for (auto& s : m_pending) m_sources.push_back(std::move(s));
+    m_pending.clear();
+    std::stable_sort(m_sources.begin(), m_sources.end(), [](auto& a, auto& b) { return a->priority > b->priority; });
+  }
+
+  int block_timeout_ms() const {
+    int timeout = m_config.idle_timeout_ms;
+    uint64_t now = now_ns();
+    for (auto& s : m_sources) {
+      if (s->removed || !s->next_deadline) continue;
+      uint64_t deadline = s->next_deadline();
+      if (deadline <= now) return 0;
+      timeout = std::min<uint64_t>(timeout, (deadline - now + 999999) / 1000000);
+    }
+    return timeout;
+  }
+
+  size_t poll_fds(int timeout_ms) {
+    epoll_event events[MAX_EVENTS];
+    ++m_fd_polls;
+    int n = epoll_wait(m_epoll, events, MAX_EVENTS, timeout_ms);
+    if (n <= 0) return 0;
+    // fds ready together are served by priority too
+    std::sort(events, events + n, [this](const epoll_event& a, const epoll_event& b) {
+      return priority_of(a.data.u64) > priority_of(b.data.u64);
+    });
+    size_t dispatched = 0;
+    for (int i = 0; i < n; ++i) {
+      uint64_t id = events[i].data.u64;
+      if (id == WAKE_ID) {
+        uint64_t v;
+        ssize_t ret = read(m_wake, &v, sizeof(v));
+        (void)ret;
+        continue;
+      }
+      if (id >= m_by_id.size() || m_by_id[id] == nullptr) continue;  // removed by an earlier callback
+      Source& s = *m_by_id[id];
+      s.on_fd(s.fd);
+      ++s.dispatched;
+      ++s.busy_polls;
+      ++dispatched;
+    }
+    return dispatched;
+  }
+
+  int priority_of(uint64_t id) const {
+    if (id >= m_by_id.size() || m_by_id[id] == nullptr) return INT32_MAX;  // wake up first
+    return m_by_id[id]->priority;
+  }
+
+  EventLoopConfig m_config;
+  int m_epoll{-1};
+  int m_wake{-1};
+  std::atomic<bool> m_stop{false};
+  std::vector<std::unique_ptr<Source>> m_sources;  // polled, highest priority first
+  std::vector<std::unique_ptr<Source>> m_pending;  // added since the last iteration
+  std::vector<Source*> m_by_id;                    // SourceId -> source, nullptr once removed
+  uint64_t m_iterations{0};
+  size_t m_fd_sources{0};  // live fds in epoll besides the wake fd
+  int m_fd_skipped{0};     // non blocking iterations since the last fd poll
+  uint64_t m_fd_polls{0};
+  Histogram m_latency;
+};
+}  // namespace zerg
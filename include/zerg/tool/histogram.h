@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace zerg {
+/**
+ * lock-free log-linear histogram for latencies, any number of threads may record()
+ * every power of two range is split in 4 buckets, so a reported value is within 25% of the real one,
+ * recording is one clz and three relaxed atomic adds
+ */
+class Histogram {
+  public:
+  static constexpr int SUB_BITS = 2;
+  static constexpr int SUB = 1 << SUB_BITS;
+  static constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB;
+
+  static int bucket_of(uint64_t v) noexcept {
+    if (v < SUB) return static_cast<int>(v);
+    int msb = 63 - __builtin_clzll(v);
+    int sub = static_cast<int>((v >> (msb - SUB_BITS)) & (SUB - 1));
+    return (msb - SUB_BITS + 1) * SUB + sub;
+  }
+
+  static uint64_t bucket_lower(int idx) noexcept {
+    if (idx < SUB) return static_cast<uint64_t>(idx);
+    int msb = idx / SUB + SUB_BITS - 1;
+    uint64_t sub = static_cast<uint64_t>(idx % SUB);
+    return (SUB + sub) << (msb - SUB_BITS);
+  }
+
+  static uint64_t bucket_upper(int idx) noexcept {
+    return idx + 1 < BUCKETS ? bucket_lower(idx + 1) - 1 : UINT64_MAX;
+  }
+
+  struct Snapshot {
+    std::array<uint64_t, BUCKETS> buckets{};
+    uint64_t count{0};
+    uint64_t sum{0};
+    uint64_t max{0};
+
+    double mean() const noexcept { return count ? double(sum) / count : 0.0; }
+
+    /**
+     * @param p in [0, 1], upper bound of the bucket holding the p-th value, capped by max
+     */
+    uint64_t percentile(double p) const noexcept {
+      if (count == 0) return 0;
+      uint64_t rank = static_cast<uint64_t>(p * (count - 1)) + 1;
+      uint64_t seen = 0;
+      for (int i = 0; i < BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) return std::min(bucket_upper(i), max);
+      }
+      return max;
+    }
+
+    void merge(const Snapshot& other) noexcept {
+      for (int i = 0; i < BUCKETS; ++i) buckets[i] += other.buckets[i];
+      count += other.count;
+      sum += other.sum;
+      max = std::max(max, other.max);
+    }
+
+    /**
+     * "n=100 mean=1.2us p50=1.0us p99=4.0us max=5.1us", values taken as ns
+     */
+    std::string to_string() const {
+      char buf[160];
+      snprintf(buf, sizeof(buf), "n=%lu mean=%.1fus p50=%.1fus p90=%.1fus p99=%.1fus max=%.1fus",
+               static_cast<unsigned long>(count), mean() / 1e3, percentile(0.5) / 1e3, percentile(0.9) / 1e3,
+               percentile(0.99) / 1e3, max / 1e3);
+      return buf;
+    }
+  };
+
+  void record(uint64_t v) noexcept {
+    m_buckets[bucket_of(v)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(v, std::memory_order_relaxed);
+    uint64_t cur = m_max.load(std::memory_order_relaxed);
+    while (v > cur && !m_max.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * not atomic as a whole, count and buckets may be off by the records in flight
+   */
+  Snapshot snapshot() const noexcept {
+    Snapshot s;
+    for (int i = 0; i < BUCKETS; ++i) s.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    s.count = m_count.load(std::memory_order_relaxed);
+    s.sum = m_sum.load(std::memory_order_relaxed);
+    s.max = m_max.load(std::memory_order_relaxed);
+    return s;
+  }
+
+  void reset() noexcept {
+    for (auto& b : m_buckets) b.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+  }
+
+  private:
+  std::array<std::atomic<uint64_t>, BUCKETS> m_buckets{};
+  std::atomic<uint64_t> m_count{0};
+  std::atomic<uint64_t> m_sum{0};
+  std::atomic<uint64_t> m_max{0};
+};
+}  // namespace zerg
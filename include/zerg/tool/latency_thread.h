@@ -0,0 +1,78 @@
+#pragma once
+
+#include <pthread.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <zerg/tool/histogram.h>
+
+namespace zerg {
+/**
+ * setup of a latency critical thread (market data, order gateway)
+ * the thread is pinned, optionally SCHED_FIFO, its stack and thread locals are touched before fn runs so
+ * the first messages take no page faults, then a calibration spin measures how often the core is taken away
+ */
+struct LatencyThreadConfig {
+  std::string name;                 // thread name in top/ps, 15 chars max
+  int core{-1};                     // cpu to pin to, -1 floats
+  int rt_priority{0};               // > 0: SCHED_FIFO with this priority (1..99), needs CAP_SYS_NICE
+  bool lock_memory{false};          // mlockall(MCL_CURRENT | MCL_FUTURE) for the whole process
+  size_t stack_size{8 << 20};       // 0 keeps the default
+  size_t prefault_stack{1 << 20};   // bytes of stack touched before fn, below stack_size
+  std::function<void()> prefault;   // runs on the new thread before fn, touch thread local buffers here
+  bool require_isolated{false};     // throw if core is not in isolcpus, otherwise only log a warning
+  int calibrate_ms{100};            // length of the jitter spin, 0 skips it
+  uint64_t jitter_threshold_ns{10000};  // a gap above this between two clock reads counts as a hiccup
+};
+
+struct LatencyThreadReport {
+  int core{-1};
+  bool pinned{false};
+  bool realtime{false};
+  bool memory_locked{false};
+  bool isolated{false};   // core in /sys/devices/system/cpu/isolated
+  bool nohz_full{false};  // core in /sys/devices/system/cpu/nohz_full
+  uint64_t hiccups{0};    // gaps above jitter_threshold_ns during calibration
+  Histogram::Snapshot jitter;  // ns between consecutive clock reads of the spin loop
+
+  std::string to_string() const;
+};
+
+/**
+ * owns the thread, join() or the destructor waits for fn to return
+ */
+class LatencyThread {
+  public:
+  LatencyThread() = default;
+  LatencyThread(LatencyThread&& other) noexcept;
+  LatencyThread& operator=(LatencyThread&& other) noexcept;
+  LatencyThread(const LatencyThread&) = delete;
+  LatencyThread& operator=(const LatencyThread&) = delete;
+  ~LatencyThread();
+
+  bool joinable() const noexcept { return m_joinable; }
+  void join();
+  pthread_t native_handle() const noexcept { return m_thread; }
+  const LatencyThreadReport& report() const noexcept { return m_report; }
+
+  private:
+  friend LatencyThread spawn_latency_thread(const LatencyThreadConfig& config, std::function<void()> fn);
+
+  pthread_t m_thread{};
+  bool m_joinable{false};
+  LatencyThreadReport m_report;
+};
+
+/**
+ * starts fn on a new thread once setup and calibration are done, blocks until then and logs the report
+ * @throw std::runtime_error if the thread can not be created or pinned, or require_isolated is not met,
+ * a failed SCHED_FIFO or mlockall is only logged (report() tells), so an unprivileged test run still works
+ */
+LatencyThread spawn_latency_thread(const LatencyThreadConfig& config, std::function<void()> fn);
+
+/**
+ * spin on clock_gettime for ms and record the gaps between reads, run on the thread to check
+ */
+Histogram::Snapshot MeasureJitter(int ms, uint64_t threshold_ns = 10000, uint64_t* hiccups = nullptr);
+}  // namespace zerg
@@ -1,31 +1,93 @@
 #pragma once
 
-#include <cassert>
+#include <sys/mman.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <vector>
 
 namespace zerg {
 constexpr size_t _POOL_PREPARE_TIMES = 5;
-template <typename TData, size_t MEM_POOL_SIZE = 10000>
+constexpr size_t _HUGE_PAGE_SIZE = 2 << 20;
+
+namespace detail {
+/**
+ * raw memory for a pool slab, nothing is constructed
+ * huge: anonymous mmap aligned to 2MB and advised MADV_HUGEPAGE, so transparent huge pages back it when enabled,
+ * bytes is then a multiple of 2MB
+ */
+inline char *alloc_slab(size_t bytes, size_t align, bool huge) {
+  if (!huge) return static_cast<char *>(::operator new(bytes, std::align_val_t(align)));
+  // over map by one huge page and cut both ends, mmap alone only aligns to 4K
+  size_t len = bytes + _HUGE_PAGE_SIZE;
+  void *raw = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) throw std::bad_alloc();
+  auto begin = reinterpret_cast<uintptr_t>(raw);
+  auto aligned = (begin + _HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(_HUGE_PAGE_SIZE - 1);
+  if (aligned > begin) munmap(raw, aligned - begin);
+  size_t tail = begin + len - (aligned + bytes);
+  if (tail > 0) munmap(reinterpret_cast<void *>(aligned + bytes), tail);
+#ifdef MADV_HUGEPAGE
+  madvise(reinterpret_cast<void *>(aligned), bytes, MADV_HUGEPAGE);
+#endif
+  return reinterpret_cast<char *>(aligned);
+}
+
+inline void free_slab(char *p, size_t bytes, size_t align, bool huge) {
+  if (huge) {
+    munmap(p, bytes);
+  } else {
+    ::operator delete(p, std::align_val_t(align));
+  }
+}
+}  // namespace detail
+
+/**
+ * single threaded free list pool, blocks are carved from raw slabs of MEM_POOL_SIZE (more with huge pages),
+ * no constructor or destructor of TData runs, see ObjectPool for that
+ * ALIGN pads every block to that alignment, 64 keeps hot objects on their own cache line
+ */
+template <typename TData, size_t MEM_POOL_SIZE = 10000, size_t ALIGN = alignof(TData)>
 struct MemPool {
   struct node_t {
     struct node_t *m_next;
   };
 
-  MemPool() {
-    assert(sizeof(TData) >= sizeof(void *));
+  static_assert((ALIGN & (ALIGN - 1)) == 0 && ALIGN >= alignof(TData), "ALIGN must be a power of 2 >= alignof(TData)");
+  static constexpr size_t ALIGNMENT = ALIGN > alignof(node_t) ? ALIGN : alignof(node_t);
+  // bytes between two blocks
+  static constexpr size_t STRIDE =
+    ((sizeof(TData) > sizeof(node_t) ? sizeof(TData) : sizeof(node_t)) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  static constexpr size_t SLAB_ALIGN = ALIGNMENT > 64 ? ALIGNMENT : 64;
+
+  /**
+   * @param prepare blocks touched up front so the first allocations do not grow the pool, 0 grows lazily
+   * @param huge_pages slabs from 2MB aligned mmap with MADV_HUGEPAGE, for pools of many GB
+   */
+  explicit MemPool(size_t prepare = MEM_POOL_SIZE * _POOL_PREPARE_TIMES, bool huge_pages = false)
+      : m_huge(huge_pages),
+        m_slab_bytes(huge_pages ? (MEM_POOL_SIZE * STRIDE + _HUGE_PAGE_SIZE - 1) / _HUGE_PAGE_SIZE * _HUGE_PAGE_SIZE
+                                : MEM_POOL_SIZE * STRIDE),
+        m_slab_blocks(m_slab_bytes / STRIDE) {
     m_barn.reserve(1000);
     std::vector<TData *> ptrs;
-    ptrs.reserve(MEM_POOL_SIZE * _POOL_PREPARE_TIMES);
-    for (size_t i = 0; i < MEM_POOL_SIZE * _POOL_PREPARE_TIMES; ++i) ptrs.push_back(allocate());
+    ptrs.reserve(prepare);
+    for (size_t i = 0; i < prepare; ++i) ptrs.push_back(allocate());
     for (auto *ptr : ptrs) deallocate(ptr);
   }
 
   ~MemPool() {
-    for (auto ptr : m_barn) delete ptr;
+    for (auto *slab : m_barn) detail::free_slab(slab, m_slab_bytes, SLAB_ALIGN, m_huge);
     m_barn.clear();
   }
 
+  MemPool(const MemPool &) = delete;
+  MemPool &operator=(const MemPool &) = delete;
+
   inline TData *allocate() {
     if (m_cnt > 0) {
       return placement_new_data();
@@ -45,21 +107,308 @@ struct MemPool {
     m_free_list = node;  // add to head
   }
 
+  /**
+   * give every slab whose blocks are all free back to the system, the free list keeps its order otherwise
+   * walks the whole free list, call it off the hot path, e.g. after the open or at the lunch break
+   * @return bytes released
+   */
+  size_t trim() {
+    if (m_barn.empty()) return 0;
+    std::vector<char *> sorted(m_barn);
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<size_t> free_cnt(sorted.size(), 0);
+    auto slab_of = [&](const void *p) {
+      auto it = std::upper_bound(sorted.begin(), sorted.end(), static_cast<const char *>(p));
+      return static_cast<size_t>(it - sorted.begin()) - 1;
+    };
+    for (node_t *n = m_free_list; n; n = n->m_next) ++free_cnt[slab_of(n)];
+    // blocks of the current slab not carved yet are free too
+    if (m_cnt > 0) free_cnt[slab_of(m_curr)] += m_cnt;
+
+    std::vector<bool> release(sorted.size());
+    size_t released = 0;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+      release[i] = free_cnt[i] == m_slab_blocks;
+      released += release[i];
+    }
+    if (released == 0) return 0;
+
+    node_t **link = &m_free_list;
+    for (node_t *n = m_free_list; n; n = n->m_next) {
+      if (!release[slab_of(n)]) {
+        *link = n;
+        link = &n->m_next;
+      }
+    }
+    *link = nullptr;
+    if (m_cnt > 0 && release[slab_of(m_curr)]) {
+      m_curr = nullptr;
+      m_cnt = 0;
+    }
+    for (size_t i = 0; i < sorted.size(); ++i) {
+      if (release[i]) detail::free_slab(sorted[i], m_slab_bytes, SLAB_ALIGN, m_huge);
+    }
+    m_barn.erase(std::remove_if(m_barn.begin(), m_barn.end(),
+                                [&](char *slab) { return release[slab_of(slab)]; }),
+                 m_barn.end());
+    return released * m_slab_bytes;
+  }
+
+  /**
+   * blocks obtained from the system so far, free or not
+   */
+  size_t capacity() const { return m_barn.size() * m_slab_blocks; }
+  size_t slab_count() const { return m_barn.size(); }
+  size_t slab_bytes() const { return m_slab_bytes; }
+
   private:
   TData *placement_new_data() {
-    TData *ret = m_curr->data() + (--m_cnt);
+    TData *ret = reinterpret_cast<TData *>(m_curr + (--m_cnt) * STRIDE);
     return ret;
   }
   void alloc_pool() {
-    m_curr = new std::vector<TData>(MEM_POOL_SIZE);
-    m_cnt = MEM_POOL_SIZE;
+    m_curr = detail::alloc_slab(m_slab_bytes, SLAB_ALIGN, m_huge);
+    m_cnt = m_slab_blocks;
     m_barn.push_back(m_curr);
   }
 
+  const bool m_huge;
+  const size_t m_slab_bytes;
+  const size_t m_slab_blocks;
   size_t m_cnt = 0;
   node_t *m_free_list{nullptr};
-  std::vector<TData> *m_curr{nullptr};
-  std::vector<std::vector<TData> *> m_barn;
+  char *m_curr{nullptr};
+  std::vector<char *> m_barn;
+};
+
+/**
+ * MemPool safe to use from any number of threads, a block may be freed by a thread other than the one that
+ * allocated it (queue hand-offs), it simply lands in the freeing thread's cache
+ *
+ * every thread keeps two magazines of up to MAGAZINE_SIZE free blocks per pool, allocate/deallocate touch only
+ * them. a thread with an empty pair takes a full magazine from the depot, one with a full pair pushes one there.
+ * the depot is a lock-free stack of magazines linked through the free blocks themselves, tagged against ABA.
+ * the mutex is only taken to carve a new slab of MEM_POOL_SIZE blocks and when a thread cache is created
+ * or flushed at thread exit.
+ * memory goes back to the system in the destructor, which must run after every other thread stopped using it
+ */
+template <typename TData, size_t MEM_POOL_SIZE = 10000, size_t MAGAZINE_SIZE = 64>
+class ConcurrentMemPool {
+  static_assert(MAGAZINE_SIZE >= 2 && MAGAZINE_SIZE <= MEM_POOL_SIZE, "magazine must fit in a slab");
+
+  // a free block, the first one of a magazine in the depot also holds the link to the next magazine
+  struct FreeNode {
+    FreeNode* m_next;        // next block of the same magazine
+    FreeNode* m_next_batch;  // next magazine in the depot
+    size_t m_count;          // blocks in this magazine
+  };
+
+  static constexpr size_t ALIGN = alignof(TData) > alignof(FreeNode) ? alignof(TData) : alignof(FreeNode);
+  static constexpr size_t BLOCK_SIZE =
+    ((sizeof(TData) > sizeof(FreeNode) ? sizeof(TData) : sizeof(FreeNode)) + ALIGN - 1) / ALIGN * ALIGN;
+
+  struct Magazine {
+    size_t m_count{0};
+    TData* m_items[MAGAZINE_SIZE];
+  };
+
+  // outlives the pool while threads still hold a cache for it
+  struct Shared {
+    std::mutex m_mutex;
+    ConcurrentMemPool* m_pool;
+  };
+
+  struct ThreadCache {
+    uint64_t m_pool_id{0};
+    std::shared_ptr<Shared> m_shared;
+    Magazine m_mags[2];
+    Magazine* m_loaded{&m_mags[0]};
+    Magazine* m_previous{&m_mags[1]};
+  };
+
+  struct ThreadCaches {
+    ThreadCache* m_last{nullptr};
+    std::vector<std::unique_ptr<ThreadCache>> m_caches;
+
+    ~ThreadCaches() {
+      for (auto& c : m_caches) {
+        std::lock_guard<std::mutex> lock(c->m_shared->m_mutex);
+        if (auto* pool = c->m_shared->m_pool) {
+          pool->push_magazine(*c->m_loaded);
+          pool->push_magazine(*c->m_previous);
+        }
+      }
+    }
+  };
+
+  public:
+  ConcurrentMemPool() : m_id(next_id()), m_shared(std::make_shared<Shared>()) { m_shared->m_pool = this; }
+
+  ~ConcurrentMemPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_shared->m_mutex);
+      m_shared->m_pool = nullptr;  // thread caches still pointing here drop their blocks
+    }
+    for (auto* slab : m_slabs) ::operator delete(slab, std::align_val_t(ALIGN));
+  }
+
+  ConcurrentMemPool(const ConcurrentMemPool&) = delete;
+  ConcurrentMemPool& operator=(const ConcurrentMemPool&) = delete;
+
+  /**
+   * raw storage of one TData, no constructor runs
+   */
+  TData* allocate() {
+    ThreadCache& c = cache();
+    if (c.m_loaded->m_count == 0) {
+      if (c.m_previous->m_count > 0) {
+        std::swap(c.m_loaded, c.m_previous);
+      } else {
+        refill(*c.m_loaded);
+      }
+    }
+    return c.m_loaded->m_items[--c.m_loaded->m_count];
+  }
+
+  void deallocate(TData* data) {
+    ThreadCache& c = cache();
+    if (c.m_loaded->m_count == MAGAZINE_SIZE) {
+      if (c.m_previous->m_count == MAGAZINE_SIZE) push_magazine(*c.m_previous);
+      std::swap(c.m_loaded, c.m_previous);
+    }
+    c.m_loaded->m_items[c.m_loaded->m_count++] = data;
+  }
+
+  /**
+   * blocks carved from slabs so far, free or not
+   */
+  size_t capacity() const noexcept { return m_capacity.load(std::memory_order_relaxed); }
+  size_t slab_count() const {
+    std::lock_guard<std::mutex> lock(m_shared->m_mutex);
+    return m_slabs.size();
+  }
+  /**
+   * magazines taken from / given to the depot, a low rate means the thread caches absorb the traffic
+   */
+  uint64_t depot_pops() const noexcept { return m_depot_pops.load(std::memory_order_relaxed); }
+  uint64_t depot_pushes() const noexcept { return m_depot_pushes.load(std::memory_order_relaxed); }
+
+  private:
+  static uint64_t next_id() {
+    static std::atomic<uint64_t> id{0};
+    return ++id;
+  }
+
+  static ThreadCaches& thread_caches() {
+    static thread_local ThreadCaches caches;
+    return caches;
+  }
+
+  ThreadCache& cache() {
+    ThreadCaches& tc = thread_caches();
+    if (tc.m_last != nullptr && tc.m_last->m_pool_id == m_id) return *tc.m_last;
+    return find_cache(tc);
+  }
+
+  ThreadCache& find_cache(ThreadCaches& tc) {
+    auto& v = tc.m_caches;
+    for (auto& c : v) {
+      if (c->m_pool_id == m_id) return *(tc.m_last = c.get());
+    }
+    // first use on this thread, drop caches of pools already destroyed, ids are never reused
+    for (size_t i = 0; i < v.size();) {
+      bool dead;
+      {
+        std::lock_guard<std::mutex> lock(v[i]->m_shared->m_mutex);
+        dead = v[i]->m_shared->m_pool == nullptr;
+      }
+      if (dead) {
+        v[i] = std::move(v.back());
+        v.pop_back();
+      } else {
+        ++i;
+      }
+    }
+    auto c = std::make_unique<ThreadCache>();
+    c->m_pool_id = m_id;
+    c->m_shared = m_shared;
+    v.push_back(std::move(c));
+    return *(tc.m_last = v.back().get());
+  }
+
+  // a tagged pointer, the low 48 bits are the address, the high 16 a counter bumped on every push
+  static FreeNode* untag(uint64_t v) noexcept { return reinterpret_cast<FreeNode*>(v & ((1ULL << 48) - 1)); }
+  static uint64_t tag(FreeNode* p, uint64_t prev) noexcept {
+    return reinterpret_cast<uint64_t>(p) | (((prev >> 48) + 1) << 48);
+  }
+
+  void push_magazine(Magazine& m) {
+    if (m.m_count == 0) return;
+    auto* head = reinterpret_cast<FreeNode*>(m.m_items[0]);
+    FreeNode* prev = head;
+    for (size_t i = 1; i < m.m_count; ++i) {
+      auto* n = reinterpret_cast<FreeNode*>(m.m_items[i]);
+      prev->m_next = n;
+      prev = n;
+    }
+    prev->m_next = nullptr;
+    head->m_count = m.m_count;
+    m.m_count = 0;
+
+    uint64_t top = m_depot.load(std::memory_order_relaxed);
+    do {
+      __atomic_store_n(&head->m_next_batch, untag(top), __ATOMIC_RELAXED);
+    } while (!m_depot.compare_exchange_weak(top, tag(head, top), std::memory_order_release,
+                                            std::memory_order_relaxed));
+    m_depot_pushes.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  bool pop_magazine(Magazine& m) {
+    uint64_t top = m_depot.load(std::memory_order_acquire);
+    FreeNode* head;
+    do {
+      head = untag(top);
+      if (head == nullptr) return false;
+      // head may be popped and reused meanwhile, the read stays inside a live slab and the tag fails the CAS
+    } while (!m_depot.compare_exchange_weak(top, tag(__atomic_load_n(&head->m_next_batch, __ATOMIC_RELAXED), top),
+                                            std::memory_order_acquire, std::memory_order_acquire));
+    m_depot_pops.fetch_add(1, std::memory_order_relaxed);
+    size_t n = head->m_count;
+    FreeNode* p = head;
+    for (size_t i = 0; i < n; ++i) {
+      m.m_items[i] = reinterpret_cast<TData*>(p);
+      p = p->m_next;
+    }
+    m.m_count = n;
+    return true;
+  }
+
+  void refill(Magazine& m) {
+    if (pop_magazine(m)) return;
+    std::lock_guard<std::mutex> lock(m_shared->m_mutex);
+    if (m_carve_left < MAGAZINE_SIZE) {
+      // the tail of the previous slab goes to the depot, nothing is lost
+      Magazine rest;
+      for (; m_carve_left > 0; --m_carve_left) rest.m_items[rest.m_count++] = block(m_carve_left - 1);
+      push_magazine(rest);
+      m_slabs.push_back(static_cast<char*>(::operator new(BLOCK_SIZE * MEM_POOL_SIZE, std::align_val_t(ALIGN))));
+      m_carve_left = MEM_POOL_SIZE;
+      m_capacity.fetch_add(MEM_POOL_SIZE, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < MAGAZINE_SIZE; ++i) m.m_items[m.m_count++] = block(--m_carve_left);
+  }
+
+  TData* block(size_t i) const noexcept { return reinterpret_cast<TData*>(m_slabs.back() + i * BLOCK_SIZE); }
+
+  const uint64_t m_id;
+  std::shared_ptr<Shared> m_shared;
+  alignas(64) std::atomic<uint64_t> m_depot{0};
+  alignas(64) std::atomic<uint64_t> m_depot_pops{0};
+  std::atomic<uint64_t> m_depot_pushes{0};
+  std::atomic<size_t> m_capacity{0};
+  // guarded by m_shared->m_mutex
+  std::vector<char*> m_slabs;
+  size_t m_carve_left{0};
 };
 
 class StackAllocator {
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <zerg/tool/mem_pool.h>
+
+namespace zerg {
+enum class PoolGrowth {
+  Lazy,   // take slabs from the system on demand
+  Eager,  // touch reserve objects worth of slabs in the constructor, the open does not pay for page faults
+};
+
+/**
+ * MemPool that runs constructors and destructors, create() hands out a unique_ptr returning the object on reset
+ *
+ *   ObjectPool<Order> orders(PoolGrowth::Eager, 100000);
+ *   auto o = orders.create(id, price, qty);  // ObjectPool<Order>::Ptr
+ *   book.push_back(std::move(o));             // destroyed and recycled when book drops it
+ *
+ * single threaded like MemPool, every Ptr must be released before the pool is destroyed
+ */
+template <typename T, size_t MEM_POOL_SIZE = 10000>
+class ObjectPool {
+  // raw storage of one T, at least a pointer wide for the free list
+  union Slot {
+    alignas(T) unsigned char m_data[sizeof(T)];
+    void *m_next;
+  };
+
+  public:
+  struct Deleter {
+    ObjectPool *m_pool{nullptr};
+    void operator()(T *p) const { m_pool->destroy(p); }
+  };
+  using Ptr = std::unique_ptr<T, Deleter>;
+
+  /**
+   * @param huge_pages see MemPool
+   */
+  explicit ObjectPool(PoolGrowth growth = PoolGrowth::Lazy, size_t reserve = MEM_POOL_SIZE, bool huge_pages = false)
+      : m_pool(growth == PoolGrowth::Eager ? reserve : 0, huge_pages) {}
+
+  ObjectPool(const ObjectPool &) = delete;
+  ObjectPool &operator=(const ObjectPool &) = delete;
+
+  template <typename... Args>
+  Ptr create(Args &&...args) {
+    return Ptr(create_raw(std::forward<Args>(args)...), Deleter{this});
+  }
+
+  /**
+   * for hot paths that manage the lifetime themselves, pair with destroy()
+   */
+  template <typename... Args>
+  T *create_raw(Args &&...args) {
+    Slot *slot = m_pool.allocate();
+    T *p;
+    try {
+      p = new (slot->m_data) T(std::forward<Args>(args)...);
+    } catch (...) {
+      m_pool.deallocate(slot);
+      throw;
+    }
+    ++m_total;
+    if (++m_live > m_peak) m_peak = m_live;
+    return p;
+  }
+
+  void destroy(T *p) {
+    if (p == nullptr) return;
+    p->~T();
+    m_pool.deallocate(reinterpret_cast<Slot *>(p));
+    --m_live;
+  }
+
+  size_t live() const noexcept { return m_live; }          // created and not yet destroyed
+  size_t peak() const noexcept { return m_peak; }          // highest live
+  size_t total() const noexcept { return m_total; }        // create calls that succeeded
+  size_t capacity() const { return m_pool.capacity(); }  // objects the slabs can hold
+
+  /**
+   * release the slabs holding no live object, see MemPool::trim
+   */
+  size_t trim() { return m_pool.trim(); }
+
+  private:
+  MemPool<Slot, MEM_POOL_SIZE> m_pool;
+  size_t m_live{0};
+  size_t m_peak{0};
+  size_t m_total{0};
+};
+}  // namespace zerg
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <zerg/tool/thread_pool.h>
+
+namespace zerg {
+/**
+ * data parallel loops over a pool
+ * [begin, end) is cut into chunks of grain items, chunk k always covers the same items whatever the
+ * number of threads, parallel_reduce folds the chunk results in chunk order, so with a fixed grain the
+ * results are reproducible run to run and machine to machine
+ *
+ * the calling thread works on chunks too and helpers that start late find nothing to do, so a loop nested
+ * inside a pool task can not deadlock
+ *
+ * exec is a ThreadPool / WorkStealingPool (anything with enqueue() and size()) or OpenMPExec, which runs
+ * chunks with "omp parallel for" when compiled with -fopenmp (cmake option ZERG_OPENMP, on by default, puts it
+ * on every target linking zerg) and serially otherwise, fn must not throw there
+ */
+struct IndexRange {
+  int64_t begin{0};
+  int64_t end{0};
+  int64_t size() const noexcept { return end > begin ? end - begin : 0; }
+};
+
+struct OpenMPExec {};
+
+inline ThreadPool& default_pool() {
+  static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+  return pool;
+}
+
+namespace detail {
+struct ChunkJob {
+  const std::function<void(int64_t)>* body{nullptr};  // valid while done < chunks
+  int64_t chunks{0};
+  std::atomic<int64_t> next{0};
+  std::atomic<int64_t> done{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+  std::mutex mutex;
+  std::condition_variable cond;
+
+  void work() {
+    for (int64_t k; (k = next.fetch_add(1, std::memory_order_relaxed)) < chunks;) {
+      if (!failed.load(std::memory_order_relaxed)) {
+        try {
+          (*body)(k);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!failed.exchange(true)) error = std::current_exception();
+        }
+      }
+      if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == chunks) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cond.notify_all();
+      }
+    }
+  }
+};
+
+template <typename TPool>
+void for_chunks(TPool& pool, int64_t chunks, const std::function<void(int64_t)>& body) {
+  if (chunks <= 0) return;
+  if (chunks == 1) {
+    body(0);
+    return;
+  }
+  auto job = std::make_shared<ChunkJob>();
+  job->body = &body;
+  job->chunks = chunks;
+  int64_t helpers = std::min<int64_t>(static_cast<int64_t>(pool.size()), chunks - 1);
+  for (int64_t i = 0; i < helpers; ++i) pool.enqueue([job] { job->work(); });
+  job->work();
+  {
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->cond.wait(lock, [&] { return job->done.load(std::memory_order_acquire) == chunks; });
+  }
+  if (job->error) std::rethrow_exception(job->error);
+}
+
+inline void for_chunks(OpenMPExec, int64_t chunks, const std::function<void(int64_t)>& body) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int64_t k = 0; k < chunks; ++k) body(k);
+}
+
+inline int64_t chunk_count(const IndexRange& r, int64_t grain) {
+  if (grain < 1) grain = 1;
+  return (r.size() + grain - 1) / grain;
+}
+}  // namespace detail
+
+/**
+ * fn(int64_t chunk_begin, int64_t chunk_end)
+ */
+template <typename TExec, typename F>
+void parallel_for(TExec&& exec, IndexRange r, int64_t grain, F&& fn) {
+  if (grain < 1) grain = 1;
+  std::function<void(int64_t)> body = [&](int64_t k) {
+    int64_t b = r.begin + k * grain;
+    fn(b, std::min(b + grain, r.end));
+  };
+  detail::for_chunks(exec, detail::chunk_count(r, grain), body);
+}
+
+template <typename F>
+void parallel_for(IndexRange r, int64_t grain, F&& fn) {
+  parallel_for(default_pool(), r, grain, std::forward<F>(fn));
+}
+
+/**
+ * map(int64_t chunk_begin, int64_t chunk_end) -> T for every chunk, then
+ * combine(...combine(combine(identity, t0), t1)..., tn) in chunk order
+ */
+template <typename TExec, typename T, typename TMap, typename TCombine>
+T parallel_reduce(TExec&& exec, IndexRange r, int64_t grain, T identity, TMap&& map, TCombine&& combine) {
+  if (grain < 1) grain = 1;
+  int64_t chunks = detail::chunk_count(r, grain);
+  std::vector<T> partials(chunks, identity);
+  std::function<void(int64_t)> body = [&](int64_t k) {
+    int64_t b = r.begin + k * grain;
+    partials[k] = map(b, std::min(b + grain, r.end));
+  };
+  detail::for_chunks(exec, chunks, body);
+  T ret = identity;
+  for (auto& p : partials) ret = combine(ret, p);
+  return ret;
+}
+
+template <typename T, typename TMap, typename TCombine>
+T parallel_reduce(IndexRange r, int64_t grain, T identity, TMap&& map, TCombine&& combine) {
+  return parallel_reduce(default_pool(), r, grain, identity, std::forward<TMap>(map),
+                         std::forward<TCombine>(combine));
+}
+
+/**
+ * sort chunks of grain items in parallel then merge pairs of runs level by level
+ */
+template <typename TExec, typename RandomIt, typename Compare>
+void parallel_sort(TExec&& exec, RandomIt first, RandomIt last, Compare comp, int64_t grain = 1 << 16) {
+  int64_t n = std::distance(first, last);
+  if (grain < 1) grain = 1;
+  if (n <= grain) {
+    std::sort(first, last, comp);
+    return;
+  }
+  parallel_for(exec, IndexRange{0, n}, grain, [&](int64_t b, int64_t e) { std::sort(first + b, first + e, comp); });
+  for (int64_t width = grain; width < n; width *= 2) {
+    int64_t pairs = (n + 2 * width - 1) / (2 * width);
+    parallel_for(exec, IndexRange{0, pairs}, 1, [&](int64_t b, int64_t e) {
+      for (int64_t p = b; p < e; ++p) {
+        int64_t lo = p * 2 * width;
+        int64_t mid = std::min(lo + width, n);
+        int64_t hi = std::min(lo + 2 * width, n);
+        if (mid < hi) std::inplace_merge(first + lo, first + mid, first + hi, comp);
+      }
+    });
+  }
+}
+
+template <typename RandomIt, typename Compare>
+void parallel_sort(RandomIt first, RandomIt last, Compare comp) {
+  parallel_sort(default_pool(), first, last, comp);
+}
+
+template <typename RandomIt>
+void parallel_sort(RandomIt first, RandomIt last) {
+  parallel_sort(default_pool(), first, last, std::less<typename std::iterator_traits<RandomIt>::value_type>());
+}
+}  // namespace zerg
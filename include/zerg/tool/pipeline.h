@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace zerg {
+/**
+ * bounded multi-stage pipeline, items flow through stages linked by queues, every stage has its own
+ * threads so disk bound and cpu bound stages overlap, e.g. per date: read feather -> merge -> compute -> write
+ * at most max_in_flight items are between the source and the sink, which bounds memory (backpressure)
+ * the sink runs on the calling thread in input order, whatever order the stages finish items in
+ *
+ *   struct Job { int date; std::shared_ptr<DayData> dd; };
+ *   Pipeline<Job> pipe(8);
+ *   pipe.stage("load", 4, [](Job& j) { j.dd = load_feather_data(...); })
+ *       .stage("calc", 2, [](Job& j) { ... })
+ *       .sink([&](Job& j) { merge(j); });
+ *   pipe.run(jobs);
+ *
+ * if a stage or the sink throws, items not yet started are dropped and run() rethrows the first exception
+ * stage threads live for the duration of run(), a stage doing blocking io never holds up a shared pool
+ * T has to be default constructible and movable
+ */
+template <typename T>
+class Pipeline {
+  public:
+  struct StageStat {
+    std::string name;
+    size_t threads{0};
+    uint64_t items{0};
+    uint64_t busy_ns{0};  // summed over the stage threads
+  };
+
+  explicit Pipeline(size_t max_in_flight = 16) : m_max_in_flight(std::max<size_t>(1, max_in_flight)) {}
+
+  Pipeline(const Pipeline&) = delete;
+  Pipeline& operator=(const Pipeline&) = delete;
+
+  /**
+   * fn(T&) runs on `threads` threads, stages run in the order they are added
+   */
+  Pipeline& stage(std::string name, size_t threads, std::function<void(T&)> fn) {
+    auto s = std::make_unique<Stage>();
+    s->name = std::move(name);
+    s->threads = std::max<size_t>(1, threads);
+    s->fn = std::move(fn);
+    m_stages.push_back(std::move(s));
+    return *this;
+  }
+
+  Pipeline& sink(std::function<void(T&)> fn) {
+    m_sink = std::move(fn);
+    return *this;
+  }
+
+  /**
+   * make(i) builds item i on the calling thread just before it enters the pipeline
+   */
+  void run(size_t n, const std::function<T(size_t)>& make) {
+    m_failed = false;
+    m_error = nullptr;
+    m_done.clear();
+    m_sink_stat = StageStat{"sink", 1, 0, 0};
+    for (auto& s : m_stages) {
+      s->closed = false;
+      s->queue.clear();
+      s->items = 0;
+      s->busy_ns = 0;
+    }
+    std::vector<std::thread> threads;
+    for (size_t k = 0; k < m_stages.size(); ++k) {
+      for (size_t t = 0; t < m_stages[k]->threads; ++t) threads.emplace_back([this, k] { work(k); });
+    }
+
+    size_t next_in = 0, next_out = 0;
+    try {
+      std::unique_lock<std::mutex> lock(m_done_mutex);
+      while (next_out < n) {
+        m_done_cond.wait(lock, [&] {
+          return m_failed || (next_in < n && next_in - next_out < m_max_in_flight) || m_done.count(next_out) > 0;
+        });
+        if (m_failed) break;
+        for (auto it = m_done.find(next_out); it != m_done.end(); it = m_done.find(next_out)) {
+          T item = std::move(it->second);
+          m_done.erase(it);
+          lock.unlock();
+          auto start = clock::now();
+          if (m_sink) m_sink(item);
+          m_sink_stat.busy_ns += elapsed_ns(start);
+          ++m_sink_stat.items;
+          lock.lock();
+          ++next_out;
+        }
+        while (next_in < n && next_in - next_out < m_max_in_flight) {
+          lock.unlock();
+          T item = make(next_in);
+          forward(0, next_in, std::move(item));
+          lock.lock();
+          ++next_in;
+        }
+      }
+    } catch (...) {
+      fail(std::current_exception());
+    }
+
+    for (auto& s : m_stages) {
+      std::lock_guard<std::mutex> lock(s->mutex);
+      s->closed = true;
+      s->cond.notify_all();
+    }
+    for (auto& t : threads) t.join();
+    m_done.clear();
+    if (m_error) std::rethrow_exception(m_error);
+  }
+
+  void run(std::vector<T> items) {
+    run(items.size(), [&](size_t i) { return std::move(items[i]); });
+  }
+
+  /**
+   * stages of the last run, the sink last
+   */
+  std::vector<StageStat> stats() const {
+    std::vector<StageStat> ret;
+    for (auto& s : m_stages) ret.push_back({s->name, s->threads, s->items.load(), s->busy_ns.load()});
+    ret.push_back(m_sink_stat);
+    return ret;
+  }
+
+  /**
+   * one line per stage, busy is the average share of time its threads were working,
+   * the stage close to 100% is the one to give more threads
+   */
+  std::string report(uint64_t wall_ns) const {
+    std::string out;
+    char buf[160];
+    for (auto& s : stats()) {
+      double busy = wall_ns > 0 ? 100.0 * s.busy_ns / (double(wall_ns) * s.threads) : 0.0;
+      snprintf(buf, sizeof(buf), "  %-16s threads %2zu items %8lu busy %5.1f%%\n", s.name.c_str(), s.threads,
+               static_cast<unsigned long>(s.items), busy);
+      out += buf;
+    }
+    return out;
+  }
+
+  private:
+  using clock = std::chrono::steady_clock;
+
+  struct Stage {
+    std::string name;
+    size_t threads{1};
+    std::function<void(T&)> fn;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<std::pair<size_t, T>> queue;  // never longer than max_in_flight
+    bool closed{false};
+    std::atomic<uint64_t> items{0};
+    std::atomic<uint64_t> busy_ns{0};
+  };
+
+  static uint64_t elapsed_ns(clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+  }
+
+  /**
+   * hand item seq to stage k, or to the reorder buffer of the sink after the last stage
+   */
+  void forward(size_t k, size_t seq, T&& item) {
+    if (k < m_stages.size()) {
+      Stage& s = *m_stages[k];
+      {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.queue.emplace_back(seq, std::move(item));
+      }
+      s.cond.notify_one();
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_done_mutex);
+      m_done.emplace(seq, std::move(item));
+    }
+    m_done_cond.notify_one();
+  }
+
+  void work(size_t k) {
+    Stage& s = *m_stages[k];
+    while (true) {
+      std::pair<size_t, T> job;
+      {
+        std::unique_lock<std::mutex> lock(s.mutex);
+        s.cond.wait(lock, [&] { return s.closed || !s.queue.empty(); });
+        if (s.closed) return;
+        job = std::move(s.queue.front());
+        s.queue.pop_front();
+      }
+      try {
+        auto start = clock::now();
+        s.fn(job.second);
+        s.busy_ns.fetch_add(elapsed_ns(start), std::memory_order_relaxed);
+        s.items.fetch_add(1, std::memory_order_relaxed);
+        forward(k + 1, job.first, std::move(job.second));
+      } catch (...) {
+        fail(std::current_exception());
+      }
+    }
+  }
+
+  void fail(std::exception_ptr e) {
+    {
+      std::lock_guard<std::mutex> lock(m_done_mutex);
+      if (m_failed) return;
+      m_failed = true;
+      m_error = e;
+    }
+    m_done_cond.notify_all();
+  }
+
+  const size_t m_max_in_flight;
+  std::vector<std::unique_ptr<Stage>> m_stages;
+  std::function<void(T&)> m_sink;
+  StageStat m_sink_stat;
+
+  std::mutex m_done_mutex;
+  std::condition_variable m_done_cond;
+  std::map<size_t, T> m_done;  // finished the last stage, waiting for the sink in seq order
+  bool m_failed{false};
+  std::exception_ptr m_error;
+};
+}  // namespace zerg
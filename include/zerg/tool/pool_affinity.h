@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zerg/log.h>
+#include <zerg/unix.h>
+
+namespace zerg {
+/**
+ * where the workers of a ThreadPool / WorkStealingPool run, worker i is pinned to cores[i]
+ * an empty core list gives hardware_concurrency() floating workers, the old behaviour
+ */
+struct PoolAffinity {
+  std::vector<size_t> cores;
+  std::vector<int> nodes;  // numa node of every worker, same size as cores
+
+  size_t size() const noexcept { return cores.size(); }
+  bool empty() const noexcept { return cores.empty(); }
+
+  int node_of(size_t worker) const noexcept { return worker < nodes.size() ? nodes[worker] : 0; }
+
+  /**
+   * workers a pool built from this affinity starts
+   */
+  size_t worker_count() const noexcept {
+    if (!cores.empty()) return cores.size();
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  /**
+   * called by the pool constructor, so a bad core fails there instead of on a worker
+   * @throw std::invalid_argument if a core is outside the cpus this process may run on (taskset, cgroup cpuset)
+   */
+  void validate() const {
+    auto allowed = GetAffinity();
+    for (size_t cpu : cores) {
+      if (std::find(allowed.begin(), allowed.end(), cpu) == allowed.end()) {
+        throw std::invalid_argument("PoolAffinity: cpu " + std::to_string(cpu) + " is not in the process affinity");
+      }
+    }
+  }
+
+  /**
+   * called by worker i on its own thread, a failure is logged and the worker floats, it must not throw
+   * out of the thread body
+   */
+  void pin(size_t worker) const noexcept {
+    if (worker >= cores.size()) return;
+    try {
+      BindCore(cores[worker]);
+    } catch (const std::exception& e) {
+      ZLOG("WARN, worker %zu not pinned to cpu %zu: %s", worker, cores[worker], e.what());
+    }
+  }
+
+  static PoolAffinity Cores(const std::vector<size_t>& core_list) {
+    PoolAffinity ret;
+    ret.cores = core_list;
+    for (size_t cpu : core_list) ret.nodes.push_back(GetCpuNode(cpu));
+    return ret;
+  }
+
+  /**
+   * one worker per physical core (hyper-thread siblings skipped) on node, or on all nodes if node < 0
+   * cores outside the process affinity are left out
+   */
+  static PoolAffinity PhysicalCores(int node = -1) {
+    auto allowed = GetAffinity();
+    std::vector<size_t> usable;
+    for (size_t cpu : GetPhysicalCores(node)) {
+      if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) usable.push_back(cpu);
+    }
+    if (node >= 0) {
+      PoolAffinity ret;
+      ret.cores = usable;
+      ret.nodes.assign(ret.cores.size(), node);
+      return ret;
+    }
+    return Cores(usable);
+  }
+};
+}  // namespace zerg
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zerg/log.h>
+#include <zerg/tool/histogram.h>
+
+namespace zerg {
+/**
+ * stats policies for ThreadPoolT / WorkStealingPoolT, the pool calls
+ *   start(workers)                  once in the constructor
+ *   stamp = on_push(depth)          when a task is queued, depth is the queue size after the push
+ *   begin = on_pop(worker, stamp)   when a worker takes a task
+ *   on_done(worker, begin)          after it ran
+ *   on_steal(worker)                when a work stealing worker took a task from another one
+ * NoPoolStats does nothing and is the default, every call is an empty inline function so the counters
+ * cost nothing unless a pool is declared with PoolStats
+ */
+struct NoPoolStats {
+  static constexpr bool enabled = false;
+  void start(size_t) {}
+  uint64_t on_push(size_t) { return 0; }
+  uint64_t on_pop(size_t, uint64_t) { return 0; }
+  void on_done(size_t, uint64_t) {}
+  void on_steal(size_t) {}
+};
+
+struct PoolStatsSnapshot {
+  double elapsed_sec{0};
+  uint64_t pushed{0};
+  uint64_t executed{0};
+  uint64_t steals{0};
+  size_t queue_hwm{0};
+  Histogram::Snapshot wait_ns;  // enqueue -> start
+  Histogram::Snapshot exec_ns;
+  std::vector<double> busy_ratio;  // per worker, busy time / elapsed
+
+  std::string to_string() const {
+    char buf[256];
+    double busy = 0;
+    for (double r : busy_ratio) busy += r;
+    snprintf(buf, sizeof(buf), "pool %.1fs pushed %lu executed %lu steals %lu queue hwm %zu busy %.2f/%zu\n",
+             elapsed_sec, static_cast<unsigned long>(pushed), static_cast<unsigned long>(executed),
+             static_cast<unsigned long>(steals), queue_hwm, busy, busy_ratio.size());
+    std::string out = buf;
+    out += "  wait " + wait_ns.to_string() + "\n";
+    out += "  exec " + exec_ns.to_string() + "\n";
+    out += "  busy";
+    for (double r : busy_ratio) {
+      snprintf(buf, sizeof(buf), " %.2f", r);
+      out += buf;
+    }
+    return out;
+  }
+};
+
+class PoolStats {
+  public:
+  static constexpr bool enabled = true;
+
+  ~PoolStats() { stop_dump(); }
+
+  void start(size_t workers) {
+    m_workers.reset(new Worker[workers]);
+    m_worker_count = workers;
+    m_start.store(now(), std::memory_order_relaxed);
+  }
+
+  uint64_t on_push(size_t depth) {
+    m_pushed.fetch_add(1, std::memory_order_relaxed);
+    size_t hwm = m_queue_hwm.load(std::memory_order_relaxed);
+    while (depth > hwm && !m_queue_hwm.compare_exchange_weak(hwm, depth, std::memory_order_relaxed)) {
+    }
+    return now();
+  }
+
+  uint64_t on_pop(size_t, uint64_t stamp) {
+    uint64_t t = now();
+    if (stamp) m_wait.record(t - stamp);
+    return t;
+  }
+
+  void on_done(size_t worker, uint64_t begin) {
+    uint64_t d = now() - begin;
+    m_exec.record(d);
+    Worker& w = m_workers[worker];
+    w.busy_ns.fetch_add(d, std::memory_order_relaxed);
+    w.executed.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void on_steal(size_t worker) { m_workers[worker].steals.fetch_add(1, std::memory_order_relaxed); }
+
+  PoolStatsSnapshot snapshot() const {
+    PoolStatsSnapshot s;
+    uint64_t elapsed = now() - m_start.load(std::memory_order_relaxed);
+    s.elapsed_sec = elapsed / 1e9;
+    s.pushed = m_pushed.load(std::memory_order_relaxed);
+    s.queue_hwm = m_queue_hwm.load(std::memory_order_relaxed);
+    s.wait_ns = m_wait.snapshot();
+    s.exec_ns = m_exec.snapshot();
+    for (size_t i = 0; i < m_worker_count; ++i) {
+      const Worker& w = m_workers[i];
+      s.executed += w.executed.load(std::memory_order_relaxed);
+      s.steals += w.steals.load(std::memory_order_relaxed);
+      s.busy_ratio.push_back(elapsed ? double(w.busy_ns.load(std::memory_order_relaxed)) / elapsed : 0.0);
+    }
+    return s;
+  }
+
+  /**
+   * start over, e.g. after warm up
+   */
+  void reset() {
+    m_pushed.store(0, std::memory_order_relaxed);
+    m_queue_hwm.store(0, std::memory_order_relaxed);
+    m_wait.reset();
+    m_exec.reset();
+    for (size_t i = 0; i < m_worker_count; ++i) {
+      m_workers[i].busy_ns.store(0, std::memory_order_relaxed);
+      m_workers[i].executed.store(0, std::memory_order_relaxed);
+      m_workers[i].steals.store(0, std::memory_order_relaxed);
+    }
+    m_start.store(now(), std::memory_order_relaxed);
+  }
+
+  /**
+   * opt-in periodic dump from a background thread, by default to ZLOG
+   */
+  void start_dump(std::chrono::milliseconds interval, std::function<void(const PoolStatsSnapshot&)> sink = nullptr) {
+    stop_dump();
+    if (!sink) sink = [](const PoolStatsSnapshot& s) { ZLOG("%s", s.to_string().c_str()); };
+    m_dump_stop = false;
+    m_dumper = std::thread([this, interval, sink] {
+      std::unique_lock<std::mutex> lock(m_dump_mutex);
+      while (!m_dump_cond.wait_for(lock, interval, [this] { return m_dump_stop; })) sink(snapshot());
+    });
+  }
+
+  void stop_dump() {
+    if (!m_dumper.joinable()) return;
+    {
+      std::lock_guard<std::mutex> lock(m_dump_mutex);
+      m_dump_stop = true;
+    }
+    m_dump_cond.notify_all();
+    m_dumper.join();
+  }
+
+  private:
+  struct alignas(64) Worker {
+    std::atomic<uint64_t> busy_ns{0};
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> steals{0};
+  };
+
+  static uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  std::unique_ptr<Worker[]> m_workers;
+  size_t m_worker_count{0};
+  std::atomic<uint64_t> m_start{0};
+  alignas(64) std::atomic<uint64_t> m_pushed{0};
+  std::atomic<size_t> m_queue_hwm{0};
+  Histogram m_wait;
+  Histogram m_exec;
+  std::thread m_dumper;
+  std::mutex m_dump_mutex;
+  std::condition_variable m_dump_cond;
+  bool m_dump_stop{false};
+};
+}  // namespace zerg
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <sched.h>
+#include <atomic>
+#include <cstdint>
+#include <zerg/tool/wait_strategy.h>
+
+namespace zerg {
+/**
+ * light locks for critical sections of a few nanoseconds, all satisfy Lockable so std::lock_guard works
+ * TicketSpinLock     FIFO fair spin lock
+ * SpinFutexMutexT    spin a while then sleep on futex, PROCESS_SHARED=true works inside shm,
+ *                    zero filled memory is a valid unlocked mutex, so it can live in ChnlCtrlBlock
+ * RWSpinLock         reader-writer spin lock biased towards readers, works with std::shared_lock
+ */
+
+/**
+ * spin with pause, give up the time slice after a while in case the holder got preempted
+ */
+struct SpinBackoff {
+  static constexpr uint32_t YIELD_AFTER = 4096;
+  uint32_t m_spins{0};
+
+  void pause(uint32_t n = 1) noexcept {
+    if (m_spins < YIELD_AFTER) {
+      m_spins += n;
+      for (; n > 0; --n) cpu_relax();
+    } else {
+      sched_yield();
+    }
+  }
+};
+
+class TicketSpinLock {
+  public:
+  void lock() noexcept {
+    const uint32_t ticket = m_next.fetch_add(1, std::memory_order_relaxed);
+    SpinBackoff backoff;
+    while (true) {
+      const uint32_t serving = m_serving.load(std::memory_order_acquire);
+      if (serving == ticket) return;
+      // back off proportional to the position in line
+      backoff.pause(ticket - serving);
+    }
+  }
+
+  bool try_lock() noexcept {
+    uint32_t serving = m_serving.load(std::memory_order_acquire);
+    uint32_t expected = serving;
+    return m_next.compare_exchange_strong(expected, serving + 1, std::memory_order_acquire,
+                                          std::memory_order_relaxed);
+  }
+
+  void unlock() noexcept {
+    m_serving.store(m_serving.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  private:
+  std::atomic<uint32_t> m_next{0};
+  std::atomic<uint32_t> m_serving{0};
+};
+
+template <bool PROCESS_SHARED = false, uint32_t SPIN_N = 100>
+class SpinFutexMutexT {
+  public:
+  void lock() noexcept {
+    uint32_t c = 0;
+    if (m_state.compare_exchange_strong(c, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) return;
+    for (uint32_t i = 0; i < SPIN_N; ++i) {
+      cpu_relax();
+      c = UNLOCKED;
+      if (m_state.load(std::memory_order_relaxed) == UNLOCKED &&
+          m_state.compare_exchange_strong(c, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+        return;
+      }
+    }
+    // mark contended, whoever unlocks must wake us
+    c = m_state.exchange(CONTENDED, std::memory_order_acquire);
+    while (c != UNLOCKED) {
+      futex_wait(&m_state, CONTENDED, 0, !PROCESS_SHARED);
+      c = m_state.exchange(CONTENDED, std::memory_order_acquire);
+    }
+  }
+
+  bool try_lock() noexcept {
+    uint32_t c = UNLOCKED;
+    return m_state.compare_exchange_strong(c, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+  }
+
+  void unlock() noexcept {
+    if (m_state.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+      futex_wake(&m_state, 1, !PROCESS_SHARED);
+    }
+  }
+
+  private:
+  static constexpr uint32_t UNLOCKED = 0;
+  static constexpr uint32_t LOCKED = 1;
+  static constexpr uint32_t CONTENDED = 2;
+  std::atomic<uint32_t> m_state{UNLOCKED};
+};
+using SpinFutexMutex = SpinFutexMutexT<false>;
+using ShmSpinFutexMutex = SpinFutexMutexT<true>;
+static_assert(sizeof(ShmSpinFutexMutex) == sizeof(uint32_t), "ShmSpinFutexMutex must be a plain futex word");
+
+class RWSpinLock {
+  public:
+  void lock() noexcept {
+    SpinBackoff backoff;
+    while (true) {
+      int32_t expected = 0;
+      if (m_state.load(std::memory_order_relaxed) == 0 &&
+          m_state.compare_exchange_weak(expected, WRITER, std::memory_order_acquire, std::memory_order_relaxed)) {
+        return;
+      }
+      backoff.pause();
+    }
+  }
+
+  bool try_lock() noexcept {
+    int32_t expected = 0;
+    return m_state.compare_exchange_strong(expected, WRITER, std::memory_order_acquire, std::memory_order_relaxed);
+  }
+
+  void unlock() noexcept { m_state.fetch_and(~WRITER, std::memory_order_release); }
+
+  /**
+   * readers never wait for a pending writer, only for the one holding the lock
+   */
+  void lock_shared() noexcept {
+    SpinBackoff backoff;
+    while (!try_lock_shared()) {
+      while (m_state.load(std::memory_order_relaxed) & WRITER) backoff.pause();
+    }
+  }
+
+  bool try_lock_shared() noexcept {
+    if (m_state.fetch_add(READER, std::memory_order_acquire) & WRITER) {
+      m_state.fetch_sub(READER, std::memory_order_relaxed);
+      return false;
+    }
+    return true;
+  }
+
+  void unlock_shared() noexcept { m_state.fetch_sub(READER, std::memory_order_release); }
+
+  private:
+  static constexpr int32_t WRITER = 1;
+  static constexpr int32_t READER = 2;
+  std::atomic<int32_t> m_state{0};
+};
+}  // namespace zerg
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <zerg/tool/event_bus.h>
+
+namespace zerg {
+template <typename Signature>
+class Delegate;
+
+/**
+ * non owning callable, an object pointer plus a function pointer, two words, never allocates
+ * the member function is a template argument, so the stub calls it directly and can inline it
+ *
+ *   auto d = Delegate<void(const Order*)>::bind<&Strategy::OnOrder>(&strategy);
+ *   auto d = make_delegate<&Strategy::OnOrder>(&strategy);  // signature deduced
+ */
+template <typename R, typename... Args>
+class Delegate<R(Args...)> {
+  public:
+  Delegate() noexcept = default;
+
+  template <auto MemFn, typename T>
+  static Delegate bind(T* obj) noexcept {
+    return Delegate(const_cast<void*>(static_cast<const void*>(obj)), [](void* p, Args... args) -> R {
+      return (static_cast<T*>(p)->*MemFn)(std::forward<Args>(args)...);
+    });
+  }
+
+  template <auto Fn>
+  static Delegate bind() noexcept {
+    return Delegate(nullptr, [](void*, Args... args) -> R { return Fn(std::forward<Args>(args)...); });
+  }
+
+  /**
+   * any callable object, the delegate only points to it, f must outlive the delegate
+   */
+  template <typename F>
+  static Delegate bind_functor(F* f) noexcept {
+    return Delegate(static_cast<void*>(f), [](void* p, Args... args) -> R {
+      return (*static_cast<F*>(p))(std::forward<Args>(args)...);
+    });
+  }
+
+  R operator()(Args... args) const { return m_stub(m_obj, std::forward<Args>(args)...); }
+
+  explicit operator bool() const noexcept { return m_stub != nullptr; }
+
+  bool operator==(const Delegate& other) const noexcept { return m_obj == other.m_obj && m_stub == other.m_stub; }
+  bool operator!=(const Delegate& other) const noexcept { return !(*this == other); }
+
+  private:
+  using Stub = R (*)(void*, Args...);
+
+  Delegate(void* obj, Stub stub) noexcept : m_obj(obj), m_stub(stub) {}
+
+  void* m_obj{nullptr};
+  Stub m_stub{nullptr};
+};
+
+template <auto MemFn, typename T>
+auto make_delegate(T* obj) noexcept {
+  return Delegate<typename member_function_traits<decltype(MemFn)>::signature>::template bind<MemFn>(obj);
+}
+
+namespace detail {
+template <typename E, typename... Es>
+struct EventIndex;
+
+template <typename E, typename... Es>
+struct EventIndex<E, E, Es...> : std::integral_constant<size_t, 0> {};
+
+template <typename E, typename F, typename... Es>
+struct EventIndex<E, F, Es...> : std::integral_constant<size_t, 1 + EventIndex<E, Es...>::value> {};
+
+template <typename E>
+struct EventIndex<E> {
+  static_assert(sizeof(E) == 0, "event type not declared in this StaticEventBus");
+};
+}  // namespace detail
+
+/**
+ * EventBus with the event types fixed at compile time, an event type is any type with a signature alias
+ * every event has its own vector of delegates in a tuple, fire<E>() is a plain loop of calls with no lookup,
+ * no any_cast and no std::function
+ *
+ *   struct OnOrderEvent { using signature = void(const MDSymbol&, const Order*); };
+ *   struct OnTradeEvent { using signature = void(const MDSymbol&, const Trade*); };
+ *   StaticEventBus<OnOrderEvent, OnTradeEvent> bus;
+ *   bus.subscribe<OnOrderEvent>(make_delegate<&Strategy::OnOrder>(&strategy));
+ *   bus.fire<OnOrderEvent>(symbol, &order);
+ *
+ * subscribe while firing the same event is not allowed, not thread safe
+ */
+template <typename... Events>
+class StaticEventBus {
+  public:
+  template <typename E>
+  using delegate_type = Delegate<typename E::signature>;
+
+  template <typename E>
+  void subscribe(delegate_type<E> d) {
+    slot<E>().push_back(d);
+  }
+
+  template <typename E, auto MemFn, typename T>
+  void subscribe(T* obj) {
+    slot<E>().push_back(delegate_type<E>::template bind<MemFn>(obj));
+  }
+
+  /**
+   * @return false if d was not subscribed
+   */
+  template <typename E>
+  bool unsubscribe(delegate_type<E> d) {
+    auto& v = slot<E>();
+    auto it = std::find(v.begin(), v.end(), d);
+    if (it == v.end()) return false;
+    v.erase(it);
+    return true;
+  }
+
+  template <typename E, typename... Args>
+  void fire(Args&&... args) const {
+    // no forward, every subscriber gets the same arguments
+    for (const auto& d : slot<E>()) d(args...);
+  }
+
+  template <typename E>
+  size_t size() const noexcept {
+    return slot<E>().size();
+  }
+
+  template <typename E>
+  const std::vector<delegate_type<E>>& subscribers() const noexcept {
+    return slot<E>();
+  }
+
+  private:
+  template <typename E>
+  std::vector<delegate_type<E>>& slot() noexcept {
+    return std::get<detail::EventIndex<E, Events...>::value>(m_slots);
+  }
+
+  template <typename E>
+  const std::vector<delegate_type<E>>& slot() const noexcept {
+    return std::get<detail::EventIndex<E, Events...>::value>(m_slots);
+  }
+
+  std::tuple<std::vector<Delegate<typename Events::signature>>...> m_slots;
+};
+}  // namespace zerg
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <zerg/tool/wait_strategy.h>
+
+namespace zerg {
+/**
+ * move-only void() callable with a small buffer, callables up to BufferSize bytes (a lambda capturing
+ * ~8 pointers) live inline and cost no heap allocation, larger ones fall back to new
+ */
+class SboTask {
+  public:
+  static constexpr size_t BufferSize = 64;
+
+  SboTask() noexcept = default;
+
+  template <typename F, typename Fn = typename std::decay<F>::type,
+            typename = typename std::enable_if<!std::is_same<Fn, SboTask>::value>::type>
+  SboTask(F&& f) {  // NOLINT implicit on purpose, like std::function
+    if constexpr (fits_inline<Fn>()) {
+      new (m_buf) Fn(std::forward<F>(f));
+      m_ops = &InlineOps<Fn>::ops;
+    } else {
+      *reinterpret_cast<Fn**>(m_buf) = new Fn(std::forward<F>(f));
+      m_ops = &HeapOps<Fn>::ops;
+    }
+  }
+
+  SboTask(SboTask&& other) noexcept { take(other); }
+
+  SboTask& operator=(SboTask&& other) noexcept {
+    if (this != &other) {
+      reset();
+      take(other);
+    }
+    return *this;
+  }
+
+  SboTask(const SboTask&) = delete;
+  SboTask& operator=(const SboTask&) = delete;
+
+  ~SboTask() { reset(); }
+
+  void operator()() { m_ops->invoke(m_buf); }
+
+  explicit operator bool() const noexcept { return m_ops != nullptr; }
+
+  bool is_inline() const noexcept { return m_ops != nullptr && m_ops->is_inline; }
+
+  void reset() noexcept {
+    if (m_ops) {
+      m_ops->destroy(m_buf);
+      m_ops = nullptr;
+    }
+  }
+
+  template <typename Fn>
+  static constexpr bool fits_inline() {
+    return sizeof(Fn) <= BufferSize && alignof(Fn) <= alignof(std::max_align_t) &&
+           std::is_nothrow_move_constructible<Fn>::value;
+  }
+
+  private:
+  struct Ops {
+    void (*invoke)(void*);
+    void (*move)(void* dst, void* src) noexcept;  // leaves src destroyed
+    void (*destroy)(void*) noexcept;
+    bool is_inline;
+  };
+
+  template <typename Fn>
+  struct InlineOps {
+    static void invoke(void* p) { (*static_cast<Fn*>(p))(); }
+    static void move(void* dst, void* src) noexcept {
+      new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+      static_cast<Fn*>(src)->~Fn();
+    }
+    static void destroy(void* p) noexcept { static_cast<Fn*>(p)->~Fn(); }
+    static constexpr Ops ops{&invoke, &move, &destroy, true};
+  };
+
+  template <typename Fn>
+  struct HeapOps {
+    static void invoke(void* p) { (**static_cast<Fn**>(p))(); }
+    static void move(void* dst, void* src) noexcept { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); }
+    static void destroy(void* p) noexcept { delete *static_cast<Fn**>(p); }
+    static constexpr Ops ops{&invoke, &move, &destroy, false};
+  };
+
+  void take(SboTask& other) noexcept {
+    if (other.m_ops) {
+      other.m_ops->move(m_buf, other.m_buf);
+      m_ops = other.m_ops;
+      other.m_ops = nullptr;
+    }
+  }
+
+  alignas(std::max_align_t) unsigned char m_buf[BufferSize];
+  const Ops* m_ops{nullptr};
+};
+
+/**
+ * growable FIFO ring of SboTask, not thread safe, the slots are reused so a steady state
+ * push/pop allocates nothing, every task carries a 64 bit tag (e.g. enqueue timestamp)
+ */
+class TaskRing {
+  public:
+  explicit TaskRing(size_t capacity = 1024) {
+    size_t n = 16;
+    while (n < capacity) n <<= 1;
+    m_slots.resize(n);
+    m_tags.resize(n);
+  }
+
+  size_t size() const noexcept { return m_size; }
+  bool empty() const noexcept { return m_size == 0; }
+
+  void push(SboTask&& t, uint64_t tag = 0) {
+    if (m_size == m_slots.size()) grow();
+    size_t idx = (m_head + m_size) & (m_slots.size() - 1);
+    m_slots[idx] = std::move(t);
+    m_tags[idx] = tag;
+    ++m_size;
+  }
+
+  SboTask pop(uint64_t* tag = nullptr) {
+    SboTask t = std::move(m_slots[m_head]);
+    if (tag) *tag = m_tags[m_head];
+    m_head = (m_head + 1) & (m_slots.size() - 1);
+    --m_size;
+    return t;
+  }
+
+  private:
+  void grow() {
+    std::vector<SboTask> slots(m_slots.size() * 2);
+    std::vector<uint64_t> tags(m_slots.size() * 2);
+    for (size_t i = 0; i < m_size; ++i) {
+      size_t idx = (m_head + i) & (m_slots.size() - 1);
+      slots[i] = std::move(m_slots[idx]);
+      tags[i] = m_tags[idx];
+    }
+    m_slots.swap(slots);
+    m_tags.swap(tags);
+    m_head = 0;
+  }
+
+  std::vector<SboTask> m_slots;
+  std::vector<uint64_t> m_tags;
+  size_t m_head{0};
+  size_t m_size{0};
+};
+
+/**
+ * counter that threads can wait on until it drops to zero, unlike std::latch (C++20) it can be
+ * raised again with add(), so it also works as a wait group for a batch of tasks
+ * waiters park on a futex, count_down only makes a syscall when someone waits
+ */
+class Latch {
+  public:
+  explicit Latch(uint32_t count = 0) : m_count(count) {}
+
+  Latch(const Latch&) = delete;
+  Latch& operator=(const Latch&) = delete;
+
+  void add(uint32_t n = 1) noexcept { m_count.fetch_add(n, std::memory_order_relaxed); }
+
+  void count_down(uint32_t n = 1) noexcept {
+    if (m_count.fetch_sub(n, std::memory_order_seq_cst) != n) return;
+    if (m_waiters.load(std::memory_order_seq_cst) > 0) futex_wake(&m_count, INT_MAX);
+  }
+
+  bool try_wait() const noexcept { return m_count.load(std::memory_order_acquire) == 0; }
+
+  void wait() noexcept {
+    for (int i = 0; i < 1000; ++i) {
+      if (try_wait()) return;
+      cpu_relax();
+    }
+    m_waiters.fetch_add(1, std::memory_order_seq_cst);
+    uint32_t c;
+    while ((c = m_count.load(std::memory_order_seq_cst)) != 0) futex_wait(&m_count, c);
+    m_waiters.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  uint32_t count() const noexcept { return m_count.load(std::memory_order_relaxed); }
+
+  private:
+  alignas(64) std::atomic<uint32_t> m_count;
+  std::atomic<uint32_t> m_waiters{0};
+};
+}  // namespace zerg
@@ -1,74 +1,161 @@
 #pragma once
 
 #include <vector>
-#include <queue>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
 #include <future>
 #include <atomic>
+#include <zerg/tool/pool_affinity.h>
+#include <zerg/tool/pool_stats.h>
+#include <zerg/tool/task.h>
+#include <zerg/tool/wait_strategy.h>
 
 namespace zerg {
-class ThreadPool {
+/**
+ * TWait decides how idle workers wait for tasks, see wait_strategy.h
+ * enqueue() returns a future, submit()/submit_n() are fire and forget and allocate nothing for callables
+ * up to SboTask::BufferSize bytes, wait_all() blocks until every task submitted so far finished
+ * TStats is NoPoolStats (compiled out) or PoolStats, see pool_stats.h
+ */
+template <typename TWait = BlockingWait, typename TStats = NoPoolStats>
+class ThreadPoolT {
 public:
-  explicit ThreadPool(size_t num_threads) : stop(false) {
-    for (size_t i = 0; i < num_threads; ++i) {
-      workers.emplace_back([this] {
-        for (;;) {
-          std::function<void()> task;
-          {
-            std::unique_lock<std::mutex> lock(this->queue_mutex);
-            this->condition.wait(lock, [this] {
-              return this->stop || !this->tasks.empty();
-            });
-            if (this->stop && this->tasks.empty())
-              return;
-            task = std::move(this->tasks.front());
-            this->tasks.pop();
-          }
-          task();
-        }
-      });
-    }
+  explicit ThreadPoolT(size_t num_threads) : stop(false) { start(num_threads, PoolAffinity()); }
+
+  /**
+   * one worker per core in affinity, each pinned to its core, floating workers if affinity is empty
+   * @throw std::invalid_argument for a core this process can not run on
+   */
+  explicit ThreadPoolT(const PoolAffinity& affinity) : stop(false) {
+    affinity.validate();
+    start(affinity.worker_count(), affinity);
   }
 
   template<class F, class... Args>
   auto enqueue(F&& f, Args&&... args)
-      -> std::future<typename std::result_of<F(Args...)>::type> {
-    using return_type = typename std::result_of<F(Args...)>::type;
+      -> std::future<std::invoke_result_t<F, Args...>> {
+    using return_type = std::invoke_result_t<F, Args...>;
 
     auto task = std::make_shared<std::packaged_task<return_type()>>(
         std::bind(std::forward<F>(f), std::forward<Args>(args)...)
     );
 
     std::future<return_type> res = task->get_future();
+    inflight.add();
     {
       std::unique_lock<std::mutex> lock(queue_mutex);
 
-      if (stop)
+      if (stop) {
+        inflight.count_down();
         throw std::runtime_error("enqueue on stopped ThreadPool");
+      }
 
-      tasks.emplace([task]() { (*task)(); });
+      tasks.push([task]() { (*task)(); }, pool_stats.on_push(tasks.size() + 1));
+      pending.fetch_add(1, std::memory_order_release);
     }
-    condition.notify_one();
+    waiter.notify_one();
     return res;
   }
 
-  ~ThreadPool() {
+  /**
+   * fire and forget, f must not throw
+   */
+  template <class F>
+  void submit(F&& f) {
+    SboTask task(std::forward<F>(f));
+    inflight.add();
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex);
+      if (stop) {
+        inflight.count_down();
+        throw std::runtime_error("submit on stopped ThreadPool");
+      }
+      tasks.push(std::move(task), pool_stats.on_push(tasks.size() + 1));
+      pending.fetch_add(1, std::memory_order_release);
+    }
+    waiter.notify_one();
+  }
+
+  /**
+   * submit f(0) ... f(n - 1) under one lock, f is copied into every task
+   */
+  template <class F>
+  void submit_n(size_t n, const F& f) {
+    if (n == 0) return;
+    inflight.add(static_cast<uint32_t>(n));
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex);
+      if (stop) {
+        inflight.count_down(static_cast<uint32_t>(n));
+        throw std::runtime_error("submit on stopped ThreadPool");
+      }
+      for (size_t i = 0; i < n; ++i) tasks.push([f, i] { f(i); }, pool_stats.on_push(tasks.size() + 1));
+      pending.fetch_add(n, std::memory_order_release);
+    }
+    waiter.notify_all();
+  }
+
+  /**
+   * wait until all tasks from enqueue/submit finished, must not be called from a worker
+   */
+  void wait_all() { inflight.wait(); }
+
+  size_t size() const noexcept { return workers.size(); }
+
+  TStats& stats() noexcept { return pool_stats; }
+
+  ~ThreadPoolT() {
     {
       std::unique_lock<std::mutex> lock(queue_mutex);
       stop = true;
     }
-    condition.notify_all();
+    waiter.notify_all();
     for (std::thread &worker : workers)
       worker.join();
   }
 
 private:
+  void start(size_t num_threads, const PoolAffinity& affinity) {
+    pool_stats.start(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+      workers.emplace_back([this, i, affinity] {
+        affinity.pin(i);
+        for (;;) {
+          waiter.wait([this] {
+            return this->stop.load(std::memory_order_acquire) ||
+                   this->pending.load(std::memory_order_acquire) > 0;
+          });
+          SboTask task;
+          uint64_t stamp = 0;
+          {
+            std::unique_lock<std::mutex> lock(this->queue_mutex);
+            if (this->tasks.empty()) {
+              if (this->stop) return;
+              continue;  // other worker took it
+            }
+            task = this->tasks.pop(&stamp);
+            this->pending.fetch_sub(1, std::memory_order_relaxed);
+          }
+          uint64_t begin = this->pool_stats.on_pop(i, stamp);
+          task();
+          this->pool_stats.on_done(i, begin);
+          task.reset();  // release captures before wait_all() returns
+          this->inflight.count_down();
+        }
+      });
+    }
+  }
+
   std::vector<std::thread> workers;
-  std::queue<std::function<void()>> tasks;
+  TaskRing tasks;
   std::mutex queue_mutex;
-  std::condition_variable condition;
-  bool stop;
+  TWait waiter;
+  std::atomic<size_t> pending{0};
+  std::atomic<bool> stop;
+  Latch inflight;
+  TStats pool_stats;
 };
-}
\ No newline at end of file
+
+using ThreadPool = ThreadPoolT<>;
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace zerg {
+/**
+ * RCU style holder for config objects (INIReader, nlohmann::json ...) reloaded under load
+ * readers on hot threads pay a single acquire load, writers publish a new version by pointer swap,
+ * old versions are freed after a grace period in which every registered reader passed a quiescent point
+ *
+ * reader thread:
+ *   int slot = cfg.register_reader();
+ *   while (running) {
+ *     const T* c = cfg.get();   // valid until the next quiescent(slot)
+ *     ...
+ *     cfg.quiescent(slot);      // e.g. at top of the event loop
+ *   }
+ * writer:
+ *   cfg.reload_async([] { return std::make_unique<T>(...); });  // parse in background thread
+ */
+template <typename T>
+class Versioned {
+  public:
+  static constexpr size_t MAX_READERS = 128;
+
+  explicit Versioned(std::unique_ptr<T> init = nullptr) : m_current(init.release()) {}
+
+  ~Versioned() {
+    if (m_reloader.joinable()) m_reloader.join();
+    delete m_current.load();
+    for (auto& r : m_retired) delete r.ptr;
+  }
+
+  Versioned(const Versioned&) = delete;
+  Versioned& operator=(const Versioned&) = delete;
+
+  /**
+   * readers not registered must not hold the pointer returned by get()
+   * @return slot id used by quiescent()
+   */
+  int register_reader() {
+    for (size_t i = 0; i < MAX_READERS; ++i) {
+      bool expected = false;
+      if (m_readers[i].used.compare_exchange_strong(expected, true)) {
+        online(static_cast<int>(i));
+        return static_cast<int>(i);
+      }
+    }
+    throw std::runtime_error("Versioned: too many readers");
+  }
+
+  void unregister_reader(int slot) {
+    m_readers[slot].epoch.store(OFFLINE, std::memory_order_release);
+    m_readers[slot].used.store(false, std::memory_order_release);
+  }
+
+  const T* get() const noexcept { return m_current.load(std::memory_order_acquire); }
+
+  /**
+   * reader promises it holds no pointer from get() any more
+   */
+  void quiescent(int slot) noexcept {
+    m_readers[slot].epoch.store(m_epoch.load(std::memory_order_seq_cst), std::memory_order_release);
+  }
+
+  /**
+   * reader will not call get() for a while (e.g. before blocking), it no longer delays reclamation
+   */
+  void offline(int slot) noexcept { m_readers[slot].epoch.store(OFFLINE, std::memory_order_release); }
+
+  void online(int slot) noexcept {
+    m_readers[slot].epoch.store(m_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    // the slot must be visible to reclaim before the first get(), otherwise an old version may be freed under us
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  uint64_t version() const noexcept { return m_epoch.load(std::memory_order_acquire); }
+
+  /**
+   * swap in new version, old one is freed once all readers passed a quiescent point
+   */
+  void publish(std::unique_ptr<T> v) {
+    std::lock_guard<std::mutex> lock(m_writer_mutex);
+    T* old = m_current.exchange(v.release(), std::memory_order_seq_cst);
+    uint64_t epoch = m_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+    if (old) m_retired.push_back({old, epoch});
+    reclaim_locked();
+  }
+
+  /**
+   * free retired versions whose grace period is over, never blocks readers
+   * @return number of versions still waiting
+   */
+  size_t reclaim() {
+    std::lock_guard<std::mutex> lock(m_writer_mutex);
+    return reclaim_locked();
+  }
+
+  /**
+   * run loader in a background thread and publish its result, a failed load (exception or nullptr)
+   * keeps the current version and is reported through on_error
+   */
+  void reload_async(std::function<std::unique_ptr<T>()> loader,
+                    std::function<void(const std::string&)> on_error = nullptr) {
+    if (m_reloader.joinable()) m_reloader.join();
+    m_reloader = std::thread([this, loader = std::move(loader), on_error = std::move(on_error)] {
+      std::unique_ptr<T> v;
+      try {
+        v = loader();
+      } catch (std::exception& e) {
+        if (on_error) on_error(e.what());
+        return;
+      }
+      if (!v) {
+        if (on_error) on_error("loader returned nullptr");
+        return;
+      }
+      publish(std::move(v));
+      // give hot readers a moment to pass their quiescent point, leftovers go with the next publish/reclaim
+      for (int i = 0; i < 1000 && reclaim() > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+  }
+
+  private:
+  static constexpr uint64_t OFFLINE = std::numeric_limits<uint64_t>::max();
+
+  struct alignas(64) ReaderSlot {
+    std::atomic<uint64_t> epoch{OFFLINE};
+    std::atomic<bool> used{false};
+  };
+
+  struct Retired {
+    T* ptr;
+    uint64_t epoch;
+  };
+
+  size_t reclaim_locked() {
+    uint64_t min_epoch = OFFLINE;
+    for (auto& r : m_readers) {
+      uint64_t e = r.epoch.load(std::memory_order_seq_cst);
+      if (e < min_epoch) min_epoch = e;
+    }
+    size_t kept = 0;
+    for (auto& r : m_retired) {
+      if (r.epoch <= min_epoch) {
+        delete r.ptr;
+      } else {
+        m_retired[kept++] = r;
+      }
+    }
+    m_retired.resize(kept);
+    return kept;
+  }
+
+  std::atomic<T*> m_current;
+  alignas(64) std::atomic<uint64_t> m_epoch{0};
+  ReaderSlot m_readers[MAX_READERS];
+
+  std::mutex m_writer_mutex;
+  std::vector<Retired> m_retired;
+  std::thread m_reloader;
+};
+}  // namespace zerg
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace zerg {
+/**
+ * wait strategy policies shared by SpscQueue, Channel pollers and ThreadPool workers
+ * every strategy has the same shape:
+ *   wait(ready)   block until ready() returns true
+ *   notify_one()  wake up one waiter, called by the producer after it changed the state
+ *   notify_all()  wake up all waiters
+ * ready() is re-checked by the strategy, so notify may race with wait freely.
+ * BusySpinWait    lowest latency, burns one core
+ * SpinYieldWait   spin a while then sched_yield, keeps latency low on shared cores
+ * SpinFutexWait   spin a while then park on futex, wake up by notify or timeout
+ * BackoffWait     spin a while then sleep with exponential backoff, cheapest for CPU
+ * BlockingWait    mutex + condition variable, the classic blocking behaviour
+ */
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#else
+  asm volatile("" ::: "memory");
+#endif
+}
+
+/**
+ * @param timeout_ns 0 means wait forever
+ * @param is_private false for futex word living in shared memory
+ */
+inline long futex_wait(std::atomic<uint32_t>* addr, uint32_t expected, int64_t timeout_ns = 0, bool is_private = true) {
+  struct timespec ts {};
+  struct timespec* pts = nullptr;
+  if (timeout_ns > 0) {
+    ts.tv_sec = timeout_ns / 1000000000L;
+    ts.tv_nsec = timeout_ns % 1000000000L;
+    pts = &ts;
+  }
+  int op = is_private ? FUTEX_WAIT_PRIVATE : FUTEX_WAIT;
+  return syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), op, expected, pts, nullptr, 0);
+}
+
+inline long futex_wake(std::atomic<uint32_t>* addr, int count, bool is_private = true) {
+  int op = is_private ? FUTEX_WAKE_PRIVATE : FUTEX_WAKE;
+  return syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), op, count, nullptr, nullptr, 0);
+}
+
+struct BusySpinWait {
+  template <typename TPred>
+  void wait(TPred&& ready) {
+    while (!ready()) cpu_relax();
+  }
+  void notify_one() {}
+  void notify_all() {}
+};
+
+template <uint32_t SPIN_N = 1000>
+struct SpinYieldWaitT {
+  template <typename TPred>
+  void wait(TPred&& ready) {
+    for (uint32_t i = 0; i < SPIN_N; ++i) {
+      if (ready()) return;
+      cpu_relax();
+    }
+    while (!ready()) sched_yield();
+  }
+  void notify_one() {}
+  void notify_all() {}
+};
+using SpinYieldWait = SpinYieldWaitT<>;
+
+/**
+ * the park timeout bounds the latency when no one calls notify, e.g. the publisher of a shm Channel
+ * lives in another process and cannot reach our futex word
+ */
+template <uint32_t SPIN_N = 1000, int64_t PARK_NS = 50000>
+struct SpinFutexWaitT {
+  template <typename TPred>
+  void wait(TPred&& ready) {
+    for (uint32_t i = 0; i < SPIN_N; ++i) {
+      if (ready()) return;
+      cpu_relax();
+    }
+    while (true) {
+      uint32_t seq = m_seq.load(std::memory_order_acquire);
+      m_waiters.fetch_add(1, std::memory_order_seq_cst);
+      if (ready()) {
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+        return;
+      }
+      futex_wait(&m_seq, seq, PARK_NS);
+      m_waiters.fetch_sub(1, std::memory_order_relaxed);
+      if (ready()) return;
+    }
+  }
+  void notify_one() { wake(1); }
+  void notify_all() { wake(INT_MAX); }
+
+  private:
+  void wake(int count) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiters.load(std::memory_order_relaxed) == 0) return;
+    m_seq.fetch_add(1, std::memory_order_release);
+    futex_wake(&m_seq, count);
+  }
+
+  alignas(64) std::atomic<uint32_t> m_seq{0};
+  std::atomic<uint32_t> m_waiters{0};
+};
+using SpinFutexWait = SpinFutexWaitT<>;
+
+template <uint32_t SPIN_N = 100, int64_t MIN_SLEEP_NS = 1000, int64_t MAX_SLEEP_NS = 1000000>
+struct BackoffWaitT {
+  template <typename TPred>
+  void wait(TPred&& ready) {
+    for (uint32_t i = 0; i < SPIN_N; ++i) {
+      if (ready()) return;
+      cpu_relax();
+    }
+    int64_t sleep_ns = MIN_SLEEP_NS;
+    while (!ready()) {
+      struct timespec ts {sleep_ns / 1000000000L, sleep_ns % 1000000000L};
+      nanosleep(&ts, nullptr);
+      if (sleep_ns < MAX_SLEEP_NS) sleep_ns = std::min(sleep_ns * 2, MAX_SLEEP_NS);
+    }
+  }
+  void notify_one() {}
+  void notify_all() {}
+};
+using BackoffWait = BackoffWaitT<>;
+
+struct BlockingWait {
+  template <typename TPred>
+  void wait(TPred&& ready) {
+    if (ready()) return;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait(lock, ready);
+  }
+  void notify_one() {
+    { std::lock_guard<std::mutex> lock(m_mutex); }
+    m_cond.notify_one();
+  }
+  void notify_all() {
+    { std::lock_guard<std::mutex> lock(m_mutex); }
+    m_cond.notify_all();
+  }
+
+  private:
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+};
+}  // namespace zerg
@@ -0,0 +1,294 @@
+#pragma once
+
+#include <sched.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <zerg/algo/ChaseLevDeque.h>
+#include <zerg/tool/pool_affinity.h>
+#include <zerg/tool/pool_stats.h>
+#include <zerg/tool/wait_strategy.h>
+
+namespace zerg {
+/**
+ * work stealing thread pool, same enqueue API as ThreadPool
+ * every worker owns a Chase-Lev deque, tasks enqueued from a worker go to its own deque and are popped
+ * LIFO (cache warm), idle workers steal FIFO from others, tasks from outside go to a global injection queue
+ * a task waiting for its children must use join(future) instead of future.get(), so the waiting thread
+ * keeps running other tasks and recursive fork/join never deadlocks
+ * built from a PoolAffinity every worker is pinned, enqueue_on(node, ...) queues a task for the workers
+ * of one numa node so it runs next to the memory it touches, forked children may still be stolen across nodes
+ * TStats is NoPoolStats (compiled out) or PoolStats, queue depth there is the number of pending tasks
+ */
+template <typename TWait = BlockingWait, typename TStats = NoPoolStats>
+class WorkStealingPoolT {
+  public:
+  explicit WorkStealingPoolT(size_t num_threads) { start(num_threads == 0 ? 1 : num_threads, PoolAffinity()); }
+
+  explicit WorkStealingPoolT(const PoolAffinity& affinity) {
+    affinity.validate();
+    start(affinity.worker_count(), affinity);
+  }
+
+  ~WorkStealingPoolT() {
+    m_stop.store(true, std::memory_order_release);
+    m_waiter.notify_all();
+    for (auto& w : m_workers) w->thread.join();
+  }
+
+  template <class F, class... Args>
+  auto enqueue(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+    using return_type = std::invoke_result_t<F, Args...>;
+
+    auto task = std::make_shared<std::packaged_task<return_type()>>(
+        std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+    std::future<return_type> res = task->get_future();
+    push(new Task{[task]() { (*task)(); }, 0}, -1);
+    return res;
+  }
+
+  /**
+   * like enqueue, but only workers on numa node take the task, falls back to any worker if the pool
+   * has none there
+   */
+  template <class F, class... Args>
+  auto enqueue_on(int node, F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+    using return_type = std::invoke_result_t<F, Args...>;
+
+    auto task = std::make_shared<std::packaged_task<return_type()>>(
+        std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+    std::future<return_type> res = task->get_future();
+    push(new Task{[task]() { (*task)(); }, 0}, node);
+    return res;
+  }
+
+  /**
+   * wait for a future while running other tasks, use it instead of get() inside tasks
+   */
+  template <typename R>
+  R join(std::future<R>& f) {
+    while (f.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      if (!run_one()) sched_yield();
+    }
+    return f.get();
+  }
+
+  /**
+   * run one pending task on the calling thread
+   * @return false if nothing found
+   */
+  bool run_one() {
+    int self = this_worker();
+    Task* t = find_task(self);
+    if (t == nullptr) return false;
+    execute(t, self);
+    return true;
+  }
+
+  size_t size() const noexcept { return m_workers.size(); }
+
+  int node_of(size_t worker) const noexcept { return m_workers[worker]->node; }
+
+  TStats& stats() noexcept { return m_stats; }
+
+  /**
+   * @return worker index of calling thread in this pool, -1 if not a worker
+   */
+  int this_worker() const noexcept {
+    auto& ctx = context();
+    return ctx.pool == this ? ctx.index : -1;
+  }
+
+  private:
+  struct Task {
+    std::function<void()> fn;
+    uint64_t stamp;
+  };
+
+  struct Worker {
+    ChaseLevDeque<Task*> deque;
+    std::thread thread;
+    uint64_t rng{0};
+    int node{0};
+  };
+
+  struct InjectQueue {
+    std::mutex mutex;
+    std::deque<Task*> tasks;
+    std::atomic<size_t> count{0};  // lets workers skip the mutex when empty
+
+    void push(Task* t) {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks.push_back(t);
+      count.fetch_add(1, std::memory_order_release);
+    }
+
+    Task* pop() {
+      if (count.load(std::memory_order_acquire) == 0) return nullptr;
+      std::lock_guard<std::mutex> lock(mutex);
+      if (tasks.empty()) return nullptr;
+      Task* t = tasks.front();
+      tasks.pop_front();
+      count.fetch_sub(1, std::memory_order_relaxed);
+      return t;
+    }
+  };
+
+  struct Context {
+    const void* pool{nullptr};
+    int index{-1};
+  };
+
+  static Context& context() {
+    thread_local Context ctx;
+    return ctx;
+  }
+
+  void start(size_t num_threads, const PoolAffinity& affinity) {
+    m_stats.start(num_threads);
+    int max_node = 0;
+    for (size_t i = 0; i < num_threads; ++i) {
+      m_workers.emplace_back(new Worker);
+      m_workers[i]->node = affinity.node_of(i);
+      max_node = std::max(max_node, m_workers[i]->node);
+    }
+    for (int n = 0; n <= max_node; ++n) m_node_inject.emplace_back(new InjectQueue);
+    for (size_t i = 0; i < num_threads; ++i) {
+      m_workers[i]->thread = std::thread([this, i, affinity] {
+        affinity.pin(i);
+        run(i);
+      });
+    }
+  }
+
+  bool has_node(int node) const noexcept {
+    if (node < 0 || node >= static_cast<int>(m_node_inject.size())) return false;
+    for (auto& w : m_workers) {
+      if (w->node == node) return true;
+    }
+    return false;
+  }
+
+  void push(Task* t, int node) {
+    int self = this_worker();
+    // running tasks may still fork children while the pool drains
+    if (self < 0 && m_stop.load(std::memory_order_acquire)) {
+      delete t;
+      throw std::runtime_error("enqueue on stopped WorkStealingPool");
+    }
+    bool to_node = node >= 0 && has_node(node);
+    // count before publish, so a worker taking it never sees pending below zero
+    // node count first, workers of other nodes must not see it as a task they could take
+    if (to_node) m_node_queued.fetch_add(1, std::memory_order_release);
+    int64_t depth = m_pending.fetch_add(1, std::memory_order_release) + 1;
+    t->stamp = m_stats.on_push(static_cast<size_t>(depth));
+    if (to_node) {
+      m_node_inject[node]->push(t);
+      m_waiter.notify_all();  // notify_one may wake a worker of another node
+      return;
+    }
+    if (self >= 0) {
+      m_workers[self]->deque.push(t);
+    } else {
+      m_inject.push(t);
+    }
+    m_waiter.notify_one();
+  }
+
+  Task* find_task(int self) {
+    Task* t = nullptr;
+    if (self >= 0 && m_workers[self]->deque.take(t)) return t;
+    int node = self >= 0 ? m_workers[self]->node : -1;
+    if (node >= 0 && (t = m_node_inject[node]->pop())) {
+      m_node_queued.fetch_sub(1, std::memory_order_release);
+      return t;
+    }
+    if ((t = m_inject.pop())) return t;
+    // same node victims first
+    size_t n = m_workers.size();
+    size_t begin = self >= 0 ? next_rand(*m_workers[self]) % n : 0;
+    for (int pass = 0; pass < 2; ++pass) {
+      for (size_t k = 0; k < n; ++k) {
+        size_t victim = (begin + k) % n;
+        if (static_cast<int>(victim) == self) continue;
+        if (node >= 0 && (m_workers[victim]->node == node) != (pass == 0)) continue;
+        if (m_workers[victim]->deque.steal(t)) {
+          if (self >= 0) m_stats.on_steal(self);
+          return t;
+        }
+      }
+      if (node < 0) break;
+    }
+    return nullptr;
+  }
+
+  void execute(Task* t, int self) {
+    m_pending.fetch_sub(1, std::memory_order_acq_rel);
+    if (self < 0) {
+      t->fn();  // helping outsider, not a worker, no stats
+    } else {
+      uint64_t begin = m_stats.on_pop(self, t->stamp);
+      t->fn();
+      m_stats.on_done(self, begin);
+    }
+    delete t;
+  }
+
+  static uint64_t next_rand(Worker& w) {
+    // xorshift
+    w.rng ^= w.rng << 13;
+    w.rng ^= w.rng >> 7;
+    w.rng ^= w.rng << 17;
+    return w.rng;
+  }
+
+  void run(size_t index) {
+    auto& ctx = context();
+    ctx.pool = this;
+    ctx.index = static_cast<int>(index);
+    m_workers[index]->rng = 0x9E3779B97F4A7C15ULL * (index + 1);
+    while (true) {
+      Task* t = find_task(ctx.index);
+      if (t) {
+        execute(t, ctx.index);
+        continue;
+      }
+      if (m_stop.load(std::memory_order_acquire) && m_pending.load(std::memory_order_acquire) == 0) break;
+      auto& own = *m_node_inject[m_workers[index]->node];
+      m_waiter.wait([this, &own] { return m_stop.load(std::memory_order_acquire) || has_work(own); });
+      // work but nothing found, the task is being taken by its owner right now
+      if (has_work(own)) sched_yield();
+    }
+    ctx.pool = nullptr;
+    ctx.index = -1;
+  }
+
+  /**
+   * a task this worker could run: one queued for its node, or any pending task not bound to a node,
+   * node tasks of other nodes only wait for their own workers
+   */
+  bool has_work(const InjectQueue& own) const noexcept {
+    return own.count.load(std::memory_order_acquire) > 0 ||
+           m_pending.load(std::memory_order_acquire) > m_node_queued.load(std::memory_order_acquire);
+  }
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  InjectQueue m_inject;
+  std::vector<std::unique_ptr<InjectQueue>> m_node_inject;
+  alignas(64) std::atomic<int64_t> m_pending{0};
+  std::atomic<int64_t> m_node_queued{0};  // tasks sitting in m_node_inject, part of m_pending
+  std::atomic<bool> m_stop{false};
+  TWait m_waiter;
+  TStats m_stats;
+};
+
+using WorkStealingPool = WorkStealingPoolT<>;
+}  // namespace zerg
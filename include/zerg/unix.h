@@ -25,6 +25,20 @@ std::map<std::string, std::string> ReadEnv2Definition();
 void BindCore(size_t cpu_id);
 void BindCore(std::vector<size_t>& cpu_id_list);
 
+/**
+ * cpu topology from /sys, a machine without numa info is one node 0 owning all online cpus
+ */
+std::vector<size_t> ParseCpuList(const std::string& list);  // "0-3,8,10-11"
+std::vector<size_t> GetOnlineCpus();
+int GetNumaNodeCount();
+std::vector<size_t> GetNodeCpus(int node);
+int GetCpuNode(size_t cpu_id);
+// first hardware thread of every physical core, on one node or all nodes if node < 0
+std::vector<size_t> GetPhysicalCores(int node = -1);
+// cpus taken out of the scheduler by isolcpus= and ticks stopped by nohz_full=, empty if none
+std::vector<size_t> GetIsolatedCpus();
+std::vector<size_t> GetNohzFullCpus();
+
 struct System {
     std::string program;
     int process;
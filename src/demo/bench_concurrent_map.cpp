@@ -0,0 +1,101 @@
+#include <time.h>
+#include <zerg/algo/ConcurrentHashMap.h>
+#include <cstdio>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace zerg;
+
+/**
+ * mixed read/write symbol lookup benchmark, 1..max_threads threads
+ * usage: ./demo_bench_concurrent_map [max_threads] [ops_per_thread] [write_percent] [key_count]
+ */
+static int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+struct MutexMap {
+    std::mutex m;
+    std::unordered_map<int, int64_t> map;
+    int64_t get(int k) {
+        std::lock_guard<std::mutex> lock(m);
+        auto itr = map.find(k);
+        return itr == map.end() ? 0 : itr->second;
+    }
+    void put(int k, int64_t v) {
+        std::lock_guard<std::mutex> lock(m);
+        map[k] = v;
+    }
+};
+
+struct SharedMutexMap {
+    std::shared_mutex m;
+    std::unordered_map<int, int64_t> map;
+    int64_t get(int k) {
+        std::shared_lock<std::shared_mutex> lock(m);
+        auto itr = map.find(k);
+        return itr == map.end() ? 0 : itr->second;
+    }
+    void put(int k, int64_t v) {
+        std::lock_guard<std::shared_mutex> lock(m);
+        map[k] = v;
+    }
+};
+
+struct LockFreeMap {
+    ConcurrentHashMap<int, int64_t> map;
+    int64_t get(int k) { return map.get(k, 0); }
+    void put(int k, int64_t v) { map.insert_or_assign(k, v); }
+};
+
+template <typename TMap>
+void bench(const char* name, int threads, int ops, int write_percent, int keys) {
+    TMap map;
+    for (int k = 0; k < keys / 2; ++k) map.put(k, k);  // the other half gets inserted while running
+    std::vector<std::thread> ts;
+    std::atomic<int64_t> sink{0};
+    int64_t start = now_ns();
+    for (int t = 0; t < threads; ++t) {
+        ts.emplace_back([&, t] {
+            uint64_t x = 88172645463325252ULL + t;
+            int64_t local = 0;
+            for (int i = 0; i < ops; ++i) {
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+                int k = static_cast<int>(x % keys);
+                if (static_cast<int>((x >> 32) % 100) < write_percent) {
+                    map.put(k, i);
+                } else {
+                    local += map.get(k);
+                }
+            }
+            sink += local;
+        });
+    }
+    for (auto& t : ts) t.join();
+    double mops = double(threads) * ops / double(now_ns() - start) * 1000.0;
+    printf("%-18s threads=%2d %8.2f Mops/s\n", name, threads, mops);
+}
+
+int main(int argc, char** argv) {
+    int max_threads = argc > 1 ? std::stoi(argv[1]) : 32;
+    int ops = argc > 2 ? std::stoi(argv[2]) : 1000000;
+    int write_percent = argc > 3 ? std::stoi(argv[3]) : 10;
+    int keys = argc > 4 ? std::stoi(argv[4]) : 100000;
+    printf("write %d%% keys %d\n", write_percent, keys);
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        bench<MutexMap>("mutex+umap", threads, ops, write_percent, keys);
+        bench<SharedMutexMap>("shared_mutex+umap", threads, ops, write_percent, keys);
+        bench<LockFreeMap>("ConcurrentHashMap", threads, ops, write_percent, keys);
+        printf("\n");
+    }
+    return 0;
+}
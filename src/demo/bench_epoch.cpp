@@ -0,0 +1,91 @@
+#include <time.h>
+#include <zerg/tool/epoch.h>
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace zerg;
+
+/**
+ * read side overhead of epoch reclamation against std::shared_ptr, a writer swaps the object now and then
+ * usage: ./demo_bench_epoch [max_threads] [reads_per_thread]
+ */
+struct Quote {
+    int64_t bid{0};
+    int64_t ask{0};
+};
+
+static int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+template <typename TRead>
+void run(const char* name, int threads, int reads, TRead&& read, std::function<void()> write) {
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            write();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+    std::vector<std::thread> ts;
+    std::atomic<int64_t> sink{0};
+    int64_t start = now_ns();
+    for (int t = 0; t < threads; ++t) {
+        ts.emplace_back([&] {
+            int64_t local = 0;
+            for (int i = 0; i < reads; ++i) local += read();
+            sink += local;
+        });
+    }
+    for (auto& t : ts) t.join();
+    double ns = double(now_ns() - start) / (double(threads) * reads);
+    stop = true;
+    writer.join();
+    printf("%-16s threads=%2d %7.2f ns/read (sink %ld)\n", name, threads, ns, sink.load());
+}
+
+int main(int argc, char** argv) {
+    int max_threads = argc > 1 ? std::stoi(argv[1]) : 8;
+    int reads = argc > 2 ? std::stoi(argv[2]) : 10000000;
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        // baseline, unsafe to free
+        std::atomic<Quote*> raw{new Quote};
+        std::vector<Quote*> leaked;
+        run("raw pointer", threads, reads, [&] { return raw.load(std::memory_order_acquire)->bid; },
+            [&] { leaked.push_back(raw.exchange(new Quote{1, 2})); });
+        for (auto* q : leaked) delete q;
+        delete raw.load();
+
+        std::shared_ptr<Quote> sp = std::make_shared<Quote>();
+        run("shared_ptr", threads, reads, [&] { return std::atomic_load(&sp)->bid; },
+            [&] { std::atomic_store(&sp, std::make_shared<Quote>(Quote{1, 2})); });
+
+        EpochDomain domain;
+        std::atomic<Quote*> shared{new Quote};
+        EpochDomain::Handle* writer_handle = nullptr;
+        run("epoch", threads, reads,
+            [&] {
+                // every run starts fresh reader threads
+                thread_local EpochDomain::Handle* h = nullptr;
+                if (!h) h = domain.register_thread();
+                EpochGuard g(*h);
+                return shared.load(std::memory_order_acquire)->bid;
+            },
+            [&] {
+                if (!writer_handle) writer_handle = domain.register_thread();
+                writer_handle->retire(shared.exchange(new Quote{1, 2}));
+            });
+        delete shared.load();
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <time.h>
+#include <zerg/tool/event_bus.h>
+#include <zerg/tool/static_event_bus.h>
+#include <cstdio>
+#include <string>
+
+using namespace zerg;
+
+/**
+ * EventBus against StaticEventBus with the handler shapes of eb_test.cpp, two holders per event
+ * usage: ./demo_bench_event_bus [events]
+ */
+struct MDSymbol {
+  int a;
+};
+
+struct Order {
+  int a3;
+};
+
+struct Trade {
+  int a;
+};
+
+struct CustomEvent {
+  std::string message;
+  int value;
+};
+
+constexpr int32_t EVENT_TYPE_RAW_ORDER = 0;
+constexpr int32_t EVENT_TYPE_RAW_TRADE = 1;
+constexpr int32_t EVENT_TYPE_CUSTOM = 2;
+
+using EB_CUSTOM_CB_t = std::function<void(int& to_change, const MDSymbol&, const CustomEvent*)>;
+using EB_ORDER_CB_t = std::function<void(const MDSymbol&, const Order*)>;
+using EB_TRADE_CB_t = std::function<void(const MDSymbol&, const Trade*)>;
+
+struct OrderEvent {
+  using signature = void(const MDSymbol&, const Order*);
+};
+struct TradeEvent {
+  using signature = void(const MDSymbol&, const Trade*);
+};
+struct CustomEventType {
+  using signature = void(int&, const MDSymbol&, const CustomEvent*);
+};
+using Bus = StaticEventBus<OrderEvent, TradeEvent, CustomEventType>;
+
+struct MyApi {
+  virtual ~MyApi() = default;
+  virtual void OnOrder(const MDSymbol&, const Order*) = 0;
+  virtual void OnTrade(const MDSymbol&, const Trade*) = 0;
+};
+
+struct Holder : public MyApi {
+  int64_t sum{0};
+
+  void init(EventBus* bus) {
+    bus->subscribe(EVENT_TYPE_RAW_ORDER, make_callback(this, &Holder::OnOrder));
+    bus->subscribe(EVENT_TYPE_RAW_TRADE, make_callback(this, &Holder::OnTrade));
+    bus->subscribe(EVENT_TYPE_CUSTOM, make_callback(this, &Holder::OnCustomEvent));
+  }
+
+  void init(Bus* bus) {
+    bus->subscribe<OrderEvent, &Holder::OnOrder>(this);
+    bus->subscribe<TradeEvent, &Holder::OnTrade>(this);
+    bus->subscribe<CustomEventType, &Holder::OnCustomEvent>(this);
+  }
+
+  void OnOrder(const MDSymbol& s, const Order* o) override { sum += s.a + o->a3; }
+  void OnTrade(const MDSymbol& s, const Trade* t) override { sum += s.a - t->a; }
+  void OnCustomEvent(int& to_change, const MDSymbol&, const CustomEvent* event) {
+    to_change = event->value;
+    sum += to_change;
+  }
+};
+
+static int64_t now_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static void print(const char* name, int64_t start, int events, int64_t sum) {
+  printf("%-16s %6.2f ns/event (checksum %ld)\n", name, double(now_ns() - start) / events, sum);
+}
+
+int main(int argc, char** argv) {
+  int n = argc > 1 ? std::stoi(argv[1]) : 10000000;
+  MDSymbol symbol{1};
+  Order order{3};
+  Trade trade{4};
+  CustomEvent custom{"custom", 42};
+  int val = 0;
+
+  {
+    EventBus bus;
+    Holder h0, h1;
+    h0.init(&bus);
+    h1.init(&bus);
+    int64_t start = now_ns();
+    for (int i = 0; i < n; ++i) {
+      order.a3 = i;
+      bus.fire_event<EB_ORDER_CB_t>(EVENT_TYPE_RAW_ORDER, symbol, &order);
+      bus.fire_event<EB_TRADE_CB_t>(EVENT_TYPE_RAW_TRADE, symbol, &trade);
+      bus.fire_event<EB_CUSTOM_CB_t>(EVENT_TYPE_CUSTOM, val, symbol, &custom);
+    }
+    print("EventBus", start, 3 * n, h0.sum + h1.sum);
+  }
+  {
+    Bus bus;
+    Holder h0, h1;
+    h0.init(&bus);
+    h1.init(&bus);
+    int64_t start = now_ns();
+    for (int i = 0; i < n; ++i) {
+      order.a3 = i;
+      bus.fire<OrderEvent>(symbol, &order);
+      bus.fire<TradeEvent>(symbol, &trade);
+      bus.fire<CustomEventType>(val, symbol, &custom);
+    }
+    print("StaticEventBus", start, 3 * n, h0.sum + h1.sum);
+  }
+  {
+    Holder h0, h1;
+    MyApi* apis[2] = {&h0, &h1};
+    int64_t start = now_ns();
+    for (int i = 0; i < n; ++i) {
+      order.a3 = i;
+      for (auto* api : apis) api->OnOrder(symbol, &order);
+      for (auto* api : apis) api->OnTrade(symbol, &trade);
+      for (auto* h : {&h0, &h1}) h->OnCustomEvent(val, symbol, &custom);
+    }
+    print("virtual call", start, 3 * n, h0.sum + h1.sum);
+  }
+  return 0;
+}
@@ -0,0 +1,95 @@
+#include <pthread.h>
+#include <time.h>
+#include <zerg/tool/spin_lock.h>
+#include <cstdio>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace zerg;
+
+/**
+ * contention benchmark, every thread increments a shared counter inside a tiny critical section
+ * usage: ./demo_bench_lock [max_threads] [ops_per_thread] [read_percent]
+ */
+static int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+struct PthreadSpinLock {
+    pthread_spinlock_t l;
+    PthreadSpinLock() { pthread_spin_init(&l, PTHREAD_PROCESS_PRIVATE); }
+    ~PthreadSpinLock() { pthread_spin_destroy(&l); }
+    void lock() { pthread_spin_lock(&l); }
+    void unlock() { pthread_spin_unlock(&l); }
+};
+
+template <typename TLock>
+void bench_exclusive(const char* name, int threads, int ops) {
+    TLock lock;
+    int64_t counter = 0;
+    std::vector<std::thread> ts;
+    int64_t start = now_ns();
+    for (int t = 0; t < threads; ++t) {
+        ts.emplace_back([&] {
+            for (int i = 0; i < ops; ++i) {
+                std::lock_guard<TLock> guard(lock);
+                ++counter;
+            }
+        });
+    }
+    for (auto& t : ts) t.join();
+    double ns = double(now_ns() - start) / (double(threads) * ops);
+    printf("%-18s threads=%2d %8.1f ns/op\n", name, threads, ns);
+}
+
+template <typename TLock>
+void bench_read_mostly(const char* name, int threads, int ops, int read_percent) {
+    TLock lock;
+    int64_t value = 0, sink = 0;
+    std::vector<std::thread> ts;
+    int64_t start = now_ns();
+    for (int t = 0; t < threads; ++t) {
+        ts.emplace_back([&, t] {
+            int64_t local = 0;
+            for (int i = 0; i < ops; ++i) {
+                if ((i + t) % 100 < read_percent) {
+                    std::shared_lock<TLock> guard(lock);
+                    local += value;
+                } else {
+                    std::lock_guard<TLock> guard(lock);
+                    ++value;
+                }
+            }
+            std::lock_guard<TLock> guard(lock);
+            sink += local;
+        });
+    }
+    for (auto& t : ts) t.join();
+    double ns = double(now_ns() - start) / (double(threads) * ops);
+    printf("%-18s threads=%2d %8.1f ns/op (sink %ld)\n", name, threads, ns, sink);
+}
+
+int main(int argc, char** argv) {
+    int max_threads = argc > 1 ? std::stoi(argv[1]) : 8;
+    int ops = argc > 2 ? std::stoi(argv[2]) : 1000000;
+    int read_percent = argc > 3 ? std::stoi(argv[3]) : 95;
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        bench_exclusive<std::mutex>("std::mutex", threads, ops);
+        bench_exclusive<PthreadSpinLock>("pthread_spin", threads, ops);
+        bench_exclusive<TicketSpinLock>("TicketSpinLock", threads, ops);
+        bench_exclusive<SpinFutexMutex>("SpinFutexMutex", threads, ops);
+        bench_exclusive<ShmSpinFutexMutex>("ShmSpinFutexMutex", threads, ops);
+        printf("read %d%%\n", read_percent);
+        bench_read_mostly<std::shared_mutex>("std::shared_mutex", threads, ops, read_percent);
+        bench_read_mostly<RWSpinLock>("RWSpinLock", threads, ops, read_percent);
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <time.h>
+#include <zerg/algo/SpscQueue.h>
+#include <zerg/tool/mem_pool.h>
+#include <zerg/tool/wait_strategy.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace zerg;
+
+/**
+ * malloc against MemPool and ConcurrentMemPool with the allocation patterns allocator benchmarks use
+ *   burst    allocate a batch, free it in reverse, repeat
+ *   churn    a window of live objects, free the oldest for every new one
+ *   handoff  one thread allocates, another frees after an SPSC queue, MemPool can not do this one
+ * usage: ./demo_bench_mem_pool [ops]
+ */
+struct Order {
+  int64_t id;
+  double price;
+  int64_t qty;
+  char symbol[40];
+};
+
+static int64_t now_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static void print(const char* pattern, const char* name, int64_t start, int64_t ops) {
+  printf("%-8s %-20s %7.2f ns/op\n", pattern, name, double(now_ns() - start) / ops);
+}
+
+struct Malloc {
+  Order* allocate() { return static_cast<Order*>(malloc(sizeof(Order))); }
+  void deallocate(Order* p) { free(p); }
+};
+
+template <typename TPool>
+void burst(const char* name, TPool& pool, int64_t ops) {
+  constexpr size_t BATCH = 1000;
+  std::vector<Order*> v(BATCH);
+  int64_t start = now_ns();
+  for (int64_t done = 0; done < ops; done += BATCH) {
+    for (size_t i = 0; i < BATCH; ++i) {
+      v[i] = pool.allocate();
+      v[i]->id = i;
+    }
+    for (size_t i = BATCH; i-- > 0;) pool.deallocate(v[i]);
+  }
+  print("burst", name, start, ops);
+}
+
+template <typename TPool>
+void churn(const char* name, TPool& pool, int64_t ops) {
+  constexpr size_t WINDOW = 4096;
+  std::vector<Order*> v(WINDOW);
+  for (auto& p : v) p = pool.allocate();
+  int64_t start = now_ns();
+  for (int64_t i = 0; i < ops; ++i) {
+    size_t slot = i % WINDOW;
+    pool.deallocate(v[slot]);
+    v[slot] = pool.allocate();
+    v[slot]->id = i;
+  }
+  print("churn", name, start, ops);
+  for (auto* p : v) pool.deallocate(p);
+}
+
+template <typename TPool>
+void handoff(const char* name, TPool& pool, int64_t ops) {
+  SpscQueue<Order*, SpinYieldWait> q(1024);
+  int64_t start = now_ns();
+  std::thread consumer([&] {
+    for (int64_t i = 0; i < ops; ++i) {
+      Order* p = *q.wait_front();
+      q.pop();
+      pool.deallocate(p);
+    }
+  });
+  for (int64_t i = 0; i < ops; ++i) {
+    Order* p = pool.allocate();
+    p->id = i;
+    q.emplace(p);
+  }
+  consumer.join();
+  print("handoff", name, start, ops);
+}
+
+int main(int argc, char** argv) {
+  int64_t ops = argc > 1 ? std::stoll(argv[1]) : 10000000;
+  Malloc m;
+  MemPool<Order> single;
+  ConcurrentMemPool<Order> concurrent;
+
+  burst("malloc", m, ops);
+  burst("MemPool", single, ops);
+  burst("ConcurrentMemPool", concurrent, ops);
+
+  churn("malloc", m, ops);
+  churn("MemPool", single, ops);
+  churn("ConcurrentMemPool", concurrent, ops);
+
+  handoff("malloc", m, ops);
+  handoff("ConcurrentMemPool", concurrent, ops);
+  printf("ConcurrentMemPool capacity %zu, depot pops %lu pushes %lu\n", concurrent.capacity(),
+         static_cast<unsigned long>(concurrent.depot_pops()), static_cast<unsigned long>(concurrent.depot_pushes()));
+  return 0;
+}
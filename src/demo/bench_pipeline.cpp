@@ -0,0 +1,72 @@
+#include <time.h>
+#include <unistd.h>
+#include <zerg/tool/pipeline.h>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace zerg;
+
+/**
+ * date by date read -> compute -> write, done serially and as a Pipeline
+ * read and write are simulated io waits, compute burns cpu
+ * usage: ./demo_bench_pipeline [dates] [io_ms] [compute_ms]
+ */
+static int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+struct DateJob {
+    int date{0};
+    std::vector<double> data;
+    double result{0};
+};
+
+static int io_ms = 20;
+static int compute_ms = 10;
+
+static void read_date(DateJob& j) {
+    usleep(io_ms * 1000);
+    j.data.assign(1 << 16, j.date);
+}
+
+static void compute(DateJob& j) {
+    int64_t end = now_ns() + compute_ms * 1000000L;
+    double acc = 0;
+    while (now_ns() < end) {
+        for (double v : j.data) acc += std::sqrt(v);
+    }
+    j.result = acc;
+}
+
+static void write_date(DateJob&) { usleep(io_ms * 1000); }
+
+int main(int argc, char** argv) {
+    int dates = argc > 1 ? std::stoi(argv[1]) : 100;
+    io_ms = argc > 2 ? std::stoi(argv[2]) : 20;
+    compute_ms = argc > 3 ? std::stoi(argv[3]) : 10;
+
+    int64_t start = now_ns();
+    for (int d = 0; d < dates; ++d) {
+        DateJob j{d, {}, 0};
+        read_date(j);
+        compute(j);
+        write_date(j);
+    }
+    printf("serial   %8.1f ms\n", (now_ns() - start) / 1e6);
+
+    Pipeline<DateJob> pipe(16);
+    int written = 0;
+    pipe.stage("read", 4, read_date).stage("compute", 2, compute).stage("write", 4, write_date).sink([&](DateJob& j) {
+        if (j.date != written++) printf("out of order %d\n", j.date);
+    });
+    start = now_ns();
+    pipe.run(dates, [](size_t d) { return DateJob{int(d), {}, 0}; });
+    int64_t wall = now_ns() - start;
+    printf("pipeline %8.1f ms\n%s", wall / 1e6, pipe.report(wall).c_str());
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <time.h>
+#include <zerg/tool/thread_pool.h>
+#include <zerg/tool/work_stealing_pool.h>
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace zerg;
+
+/**
+ * ThreadPool (one shared queue) against WorkStealingPool
+ * fib: recursive fork/join, ThreadPool can not block inside tasks so the tree is expanded on the caller
+ * tiny: lots of very small independent tasks, with enqueue (future per task) and submit/submit_n
+ * usage: ./demo_bench_thread_pool [threads] [fib_n] [tiny_tasks]
+ */
+static int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int64_t fib_serial(int n) { return n < 2 ? n : fib_serial(n - 1) + fib_serial(n - 2); }
+
+static const int CUTOFF = 20;
+
+static int64_t fib_ws(WorkStealingPool& pool, int n) {
+    if (n < CUTOFF) return fib_serial(n);
+    auto left = pool.enqueue(fib_ws, std::ref(pool), n - 1);
+    int64_t right = fib_ws(pool, n - 2);
+    return pool.join(left) + right;
+}
+
+static void expand(int n, std::vector<int>& leaves) {
+    if (n < CUTOFF) {
+        leaves.push_back(n);
+        return;
+    }
+    expand(n - 1, leaves);
+    expand(n - 2, leaves);
+}
+
+static int64_t fib_tp(ThreadPool& pool, int n) {
+    std::vector<int> leaves;
+    expand(n, leaves);
+    std::vector<std::future<int64_t>> fs;
+    fs.reserve(leaves.size());
+    for (int leaf : leaves) fs.push_back(pool.enqueue(fib_serial, leaf));
+    int64_t sum = 0;
+    for (auto& f : fs) sum += f.get();
+    return sum;
+}
+
+template <typename TPool>
+static void tiny(const char* name, TPool& pool, int tasks) {
+    std::atomic<int64_t> sum{0};
+    int64_t start = now_ns();
+    std::vector<std::future<void>> fs;
+    fs.reserve(tasks);
+    for (int i = 0; i < tasks; ++i) fs.push_back(pool.enqueue([&sum, i] { sum.fetch_add(i, std::memory_order_relaxed); }));
+    for (auto& f : fs) f.get();
+    printf("%-16s tiny  %d tasks %8.1f ns/task\n", name, tasks, double(now_ns() - start) / tasks);
+}
+
+static void tiny_submit(ThreadPool& pool, int tasks) {
+    std::atomic<int64_t> sum{0};
+    int64_t start = now_ns();
+    for (int i = 0; i < tasks; ++i) pool.submit([&sum, i] { sum.fetch_add(i, std::memory_order_relaxed); });
+    pool.wait_all();
+    printf("%-16s submit %d tasks %8.1f ns/task\n", "ThreadPool", tasks, double(now_ns() - start) / tasks);
+    start = now_ns();
+    pool.submit_n(tasks, [&sum](size_t i) { sum.fetch_add(i, std::memory_order_relaxed); });
+    pool.wait_all();
+    printf("%-16s submit_n %d tasks %8.1f ns/task\n", "ThreadPool", tasks, double(now_ns() - start) / tasks);
+}
+
+int main(int argc, char** argv) {
+    int threads = argc > 1 ? std::stoi(argv[1]) : 4;
+    int n = argc > 2 ? std::stoi(argv[2]) : 36;
+    int tasks = argc > 3 ? std::stoi(argv[3]) : 1000000;
+
+    {
+        ThreadPool pool(threads);
+        int64_t start = now_ns();
+        int64_t r = fib_tp(pool, n);
+        printf("%-16s fib(%d)=%ld %8.2f ms\n", "ThreadPool", n, r, (now_ns() - start) / 1e6);
+        tiny("ThreadPool", pool, tasks);
+        tiny_submit(pool, tasks);
+    }
+    {
+        WorkStealingPool pool(threads);
+        int64_t start = now_ns();
+        int64_t r = pool.enqueue(fib_ws, std::ref(pool), n).get();
+        printf("%-16s fib(%d)=%ld %8.2f ms\n", "WorkStealingPool", n, r, (now_ns() - start) / 1e6);
+        tiny("WorkStealingPool", pool, tasks);
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <zerg/algo/timing_wheel.h>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace zerg;
+
+/**
+ * TimingWheel against a std::multimap timer queue, the usual choice when cancel is needed
+ * schedule n timers over 10s, cancel half of them (order timeouts mostly get cancelled), then advance
+ * in 1ms steps until all fired
+ * usage: ./demo_bench_timing_wheel [timers]
+ */
+static const uint64_t TICK = 1000000;  // 1ms
+static const uint64_t SPAN = 10000000000ULL;
+
+static void report(const char* name, const char* op, int n, uint64_t start) {
+    printf("%-10s %-9s %8.1f ns/timer\n", name, op, double(monotonic_ns() - start) / n);
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    std::mt19937_64 gen(7);
+    std::vector<uint64_t> when(n);
+    for (auto& w : when) w = gen() % SPAN;
+
+    uint64_t sum = 0;
+    {
+        TimingWheelT<uint64_t> wheel(TICK, 0, n);
+        std::vector<TimingWheelT<uint64_t>::TimerId> ids(n);
+        uint64_t start = monotonic_ns();
+        for (int i = 0; i < n; ++i) ids[i] = wheel.schedule_at(when[i], i);
+        report("wheel", "schedule", n, start);
+        start = monotonic_ns();
+        for (int i = 0; i < n; i += 2) wheel.cancel(ids[i]);
+        report("wheel", "cancel", n / 2, start);
+        start = monotonic_ns();
+        for (uint64_t now = 0; !wheel.empty(); now += TICK) {
+            wheel.advance(now, [&](TimingWheelT<uint64_t>::TimerId, uint64_t& v) { sum += v; });
+        }
+        report("wheel", "expire", n / 2, start);
+    }
+    {
+        std::multimap<uint64_t, uint64_t> queue;
+        std::vector<std::multimap<uint64_t, uint64_t>::iterator> ids(n);
+        uint64_t start = monotonic_ns();
+        for (int i = 0; i < n; ++i) ids[i] = queue.emplace(when[i], i);
+        report("multimap", "schedule", n, start);
+        start = monotonic_ns();
+        for (int i = 0; i < n; i += 2) queue.erase(ids[i]);
+        report("multimap", "cancel", n / 2, start);
+        start = monotonic_ns();
+        for (uint64_t now = 0; !queue.empty(); now += TICK) {
+            auto end = queue.upper_bound(now);
+            for (auto itr = queue.begin(); itr != end; ++itr) sum -= itr->second;
+            queue.erase(queue.begin(), end);
+        }
+        report("multimap", "expire", n / 2, start);
+    }
+    printf("checksum %lu\n", static_cast<unsigned long>(sum));  // 0 when both fired the same timers
+    return 0;
+}
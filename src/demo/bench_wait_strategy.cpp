@@ -0,0 +1,68 @@
+#include <time.h>
+#include <unistd.h>
+#include <zerg/algo/SpscQueue.h>
+#include <zerg/tool/wait_strategy.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace zerg;
+
+/**
+ * producer sends one timestamped msg every interval_us, consumer blocks in wait_front()
+ * report consumer wake latency against consumer cpu usage for each wait strategy
+ * usage: ./demo_bench_wait_strategy [msg_count] [interval_us]
+ */
+static int64_t now_ns(clockid_t id = CLOCK_MONOTONIC) {
+    timespec ts;
+    clock_gettime(id, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+template <typename TWait>
+void bench(const char* name, int n, int interval_us) {
+    SpscQueue<int64_t, TWait> q(1024);
+    vector<int64_t> lat;
+    lat.reserve(n);
+    int64_t cpu_ns = 0, wall_ns = 0;
+
+    std::thread consumer([&] {
+        int64_t wall0 = now_ns(), cpu0 = now_ns(CLOCK_THREAD_CPUTIME_ID);
+        for (int i = 0; i < n; ++i) {
+            int64_t sent = *q.wait_front();
+            lat.push_back(now_ns() - sent);
+            q.pop();
+        }
+        cpu_ns = now_ns(CLOCK_THREAD_CPUTIME_ID) - cpu0;
+        wall_ns = now_ns() - wall0;
+    });
+
+    for (int i = 0; i < n; ++i) {
+        usleep(interval_us);
+        q.push(now_ns());
+    }
+    consumer.join();
+
+    std::sort(lat.begin(), lat.end());
+    double avg = 0;
+    for (auto l : lat) avg += l;
+    avg /= lat.size();
+    printf("%-12s avg=%8.0fns p50=%8ldns p99=%8ldns max=%9ldns cpu=%5.1f%%\n", name, avg, lat[lat.size() / 2],
+           lat[lat.size() * 99 / 100], lat.back(), 100.0 * cpu_ns / wall_ns);
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? std::stoi(argv[1]) : 2000;
+    int interval_us = argc > 2 ? std::stoi(argv[2]) : 200;
+    printf("msg=%d interval=%dus\n", n, interval_us);
+    bench<BusySpinWait>("busy_spin", n, interval_us);
+    bench<SpinYieldWait>("spin_yield", n, interval_us);
+    bench<SpinFutexWait>("spin_futex", n, interval_us);
+    bench<BackoffWait>("backoff", n, interval_us);
+    bench<BlockingWait>("blocking", n, interval_us);
+    return 0;
+}
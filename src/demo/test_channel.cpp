@@ -91,10 +91,11 @@ int main(int argc, char** argv) {
             ZLOG_THROW("invalid mode %s", mode.c_str());
         }
         int64_t doneIndex = -1;
+        BackoffWait waiter;
         int maxCount = subscriber->GetMaxCount();
         MyData* array = reinterpret_cast<MyData*>(subscriber->data_start);
         while (true) {
-            int64_t curIndex = subscriber->GetIndex();
+            int64_t curIndex = subscriber->WaitIndex(doneIndex, waiter);
             for (int64_t i = doneIndex + 1; i <= curIndex; ++i) {
                 visit(array[i % maxCount]);
             }
@@ -103,7 +104,6 @@ int main(int argc, char** argv) {
                 ZLOG("%ld < %ld, channel %s maybe cleared\n", curIndex, doneIndex, subscriber->name.c_str());
             }
             doneIndex = curIndex;
-            usleep(100);
         }
     } else {
         ZLOG_THROW("invalid role %s", role.c_str());
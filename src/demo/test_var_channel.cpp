@@ -1,5 +1,6 @@
 #include <unistd.h>
 #include <zerg/tool/channel.h>
+#include <zerg/tool/channel_dispatcher.h>
 #include <iomanip>
 #include <iostream>
 #include <zerg/log.h>
@@ -76,6 +77,7 @@ int main(int argc, char** argv) {
         char buffer[sizeof(ShmMsgHeader) + sizeof(MyData)];
         ShmMsgHeader* h = reinterpret_cast<ShmMsgHeader*>(buffer);
         MyData* d = reinterpret_cast<MyData*>(h + 1);
+        h->msg_type = 0;
         h->msg_len = sizeof(ShmMsgHeader) + sizeof(MyData);
         h->seq_num = 0;
         d->x = 0;
@@ -96,30 +98,11 @@ int main(int argc, char** argv) {
         } else {
             ZLOG_THROW("invalid mode %s", mode.c_str());
         }
-        int64_t doneIndex = -1;
-        const char* data = nullptr;
+        ChannelDispatcher dispatcher(subscriber);
+        dispatcher.on<MyData>(0, [](const MyData& d) { visit(d); });
+        BackoffWait waiter;
         while (true) {
-            int64_t curIndex = subscriber->GetIndex();
-            for (int64_t i = doneIndex + 1; i <= curIndex; ++i) {
-                const char* pd = subscriber->PollVar(data);
-                if (pd == nullptr) {
-                    throw std::runtime_error("should not happen");
-                }
-                auto* h = reinterpret_cast<const ShmMsgHeader*>(pd);
-                if(h->seq_num != i) {
-                    i = h->seq_num;
-                    ZLOG("caused by channel warp, set to idx=%ld,%ld,%ld\n", i, doneIndex, curIndex);
-                }
-                visit(*reinterpret_cast<const MyData*>(h + 1));
-                data = pd + h->msg_len;
-            }
-
-            if (curIndex < doneIndex) {
-                ZLOG("%ld < %ld, channel %s maybe cleared\n", curIndex, doneIndex, subscriber->name.c_str());
-                data = nullptr;
-            }
-            doneIndex = curIndex;
-            usleep(100);
+            dispatcher.wait_poll(waiter);
         }
     } else {
         ZLOG_THROW("invalid role %s", role.c_str());
@@ -0,0 +1,119 @@
+#include <unistd.h>
+#include <zerg/io/IniReader.h>
+#include <zerg/log.h>
+#include <zerg/tool/admin.h>
+#include <zerg/tool/versioned.h>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+using namespace zerg;
+
+void help() {
+    std::cout << "Program options:" << std::endl;
+    std::cout << "  -h                                    list help" << std::endl;
+    std::cout << "  -k                                    admin key" << std::endl;
+    std::cout << "  -f                                    ini file" << std::endl;
+    std::cout << "demo:" << std::endl;
+    std::cout << "server: ./demo_versioned_config -k /tmp/aaron -f /tmp/a.ini" << std::endl;
+    std::cout << "reload: ./demo_test_admin_server -k /tmp/aaron -y -c reload" << std::endl;
+}
+
+/**
+ * parse INIReader into plain fields once, hot readers never touch the map
+ */
+struct TraderConfig {
+    long order_size{0};
+    double max_position{0};
+};
+
+std::unique_ptr<TraderConfig> load_ini(const std::string& path) {
+    INIReader reader(path);
+    if (reader.ParseError() != 0) {
+        ZLOG_THROW("parse %s failed at %d", path.c_str(), reader.ParseError());
+    }
+    auto cfg = std::make_unique<TraderConfig>();
+    cfg->order_size = reader.GetIntegerOrThrow("order", "size");
+    cfg->max_position = reader.GetReal("order", "max_position", 0);
+    return cfg;
+}
+
+int main(int argc, char** argv) {
+    string key, path;
+    int opt;
+    while ((opt = getopt(argc, argv, "hk:f:")) != -1) {
+        switch (opt) {
+            case 'k':
+                key = std::string(optarg);
+                break;
+            case 'f':
+                path = std::string(optarg);
+                break;
+            case 'h':
+            default:
+                help();
+                return 1;
+        }
+    }
+
+    if (key.empty() || path.empty()) {
+        help();
+        return 1;
+    }
+
+    // the reload thread only records a failure, the main loop below is the only writer of admin
+    // declared before cfg, whose destructor joins the reload thread
+    std::mutex reload_mutex;
+    string reload_error;
+
+    Versioned<TraderConfig> cfg(load_ini(path));
+    std::atomic<bool> running{true};
+
+    // hot thread, one acquire load per iteration to read config
+    std::thread trader([&] {
+        int slot = cfg.register_reader();
+        long last_size = -1;
+        while (running) {
+            const TraderConfig* c = cfg.get();
+            long size = c->order_size;
+            if (size != last_size) {
+                ZLOG("trader sees order.size=%ld version=%lu", size, cfg.version());
+                last_size = size;
+            }
+            cfg.quiescent(slot);
+        }
+        cfg.unregister_reader(slot);
+    });
+
+    Admin admin(key);
+    admin.OpenForCreate();
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(reload_mutex);
+            if (!reload_error.empty()) {
+                admin.WriteReturn("reload failed: " + reload_error);
+                reload_error.clear();
+            }
+        }
+        string cmd = admin.ReadCmd();
+        if (cmd == "reload") {
+            cfg.reload_async([&] { return load_ini(path); },
+                             [&](const std::string& err) {
+                                 std::lock_guard<std::mutex> lock(reload_mutex);
+                                 reload_error = err;
+                             });
+            admin.WriteReturn("reloading");
+        } else if (cmd == "quit") {
+            admin.WriteReturn("bye");
+            break;
+        } else if (!cmd.empty()) {
+            admin.WriteReturn("unknown cmd " + cmd);
+        }
+        sleep(1);
+    }
+    running = false;
+    trader.join();
+    return 0;
+}
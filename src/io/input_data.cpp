@@ -7,6 +7,7 @@
 #include <zerg/io/file.h>
 #include <zerg/log.h>
 #include <zerg/string.h>
+#include <zerg/tool/parallel.h>
 
 namespace zerg {
 void DayData::build_index() {
@@ -374,23 +375,37 @@ void X_Data::merge_read(DayData& d, std::string path) {
     }
 
     mid.clear();
-    for (auto& col : to_merges) {
-        auto& vec = *reinterpret_cast<std::vector<double>*>(col.data);
-        auto pVec = mid.new_double_vec(0);
-        pVec->resize(d.x_dates->size(), NAN);
-        uint64_t merge_cnt = 0;
-        for (uint64_t i = 0; i < _ukeys->size(); ++i) {
+    // row -> position in d is the same for every column, resolve it once
+    std::vector<int64_t> row2pos(_ukeys->size(), -1);
+    parallel_for({0, (int64_t)_ukeys->size()}, 1 << 14, [&](int64_t b, int64_t e) {
+        for (int64_t i = b; i < e; ++i) {
             auto itr1 = d.ukey2tick2pos.find((*_ukeys)[i]);
             if (itr1 == d.ukey2tick2pos.end()) continue;
             auto& tick2pos = itr1->second;
             auto itr2 = tick2pos.find((*_ticks)[i]);
             if (itr2 == tick2pos.end()) continue;
-            (*pVec)[itr2->second] = vec[i];
-            merge_cnt++;
+            row2pos[i] = itr2->second;
+        }
+    });
+
+    std::vector<std::vector<double>*> pVecs;
+    for (size_t c = 0; c < to_merges.size(); ++c) {
+        auto pVec = mid.new_double_vec(0);
+        pVec->resize(d.x_dates->size(), NAN);
+        pVecs.push_back(pVec);
+    }
+    parallel_for({0, (int64_t)to_merges.size()}, 1, [&](int64_t b, int64_t e) {
+        for (int64_t c = b; c < e; ++c) {
+            auto& vec = *reinterpret_cast<std::vector<double>*>(to_merges[c].data);
+            auto& out = *pVecs[c];
+            for (uint64_t i = 0; i < row2pos.size(); ++i) {
+                if (row2pos[i] >= 0) out[row2pos[i]] = vec[i];
+            }
         }
-        d.xNames.push_back(col.name);
-        d.pXs.push_back(pVec);
-        // printf("merge %s %zu,%zu\n", col.name.c_str(), merge_cnt, _ukeys->size());
+    });
+    for (size_t c = 0; c < to_merges.size(); ++c) {
+        d.xNames.push_back(to_merges[c].name);
+        d.pXs.push_back(pVecs[c]);
     }
 }
 
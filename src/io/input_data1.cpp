@@ -9,24 +9,36 @@
 #include <zerg/string.h>
 #include <zerg/time/bizday.h>
 #include <zerg/time/dtu.h>
+#include <zerg/tool/pipeline.h>
 
 namespace zerg {
-void LoadDailyDatum(DailyDatum& item, const std::vector<int32_t>& dates, const std::unordered_map<std::string, bool>& ignore_cols, int print_every_n) {
-  int n_day = dates.size();
-  for (int di = 0; di < n_day; di++) {
-    int d_ = dates[di];
-    bool should_print = true;
-    if (print_every_n > 0) should_print = (di % print_every_n == 0);
-    if (item.input_format == "feather") {
-      auto input_file = path_join(item.input_folder, std::to_string(d_) + ".feather");
-      item.m_dds[d_] = load_feather_data(input_file, "", {}, false, should_print);
-    } else if (item.input_format == "csv") {
-      auto input_file = path_join(item.input_folder, std::to_string(d_) + ".csv");
-      item.m_dds[d_] = load_csv_data(input_file, "", {}, false, should_print);
-    } else {
-      throw std::runtime_error("not support for " + item.input_format);
-    }
+namespace {
+std::shared_ptr<DayData> load_day(const DailyDatum& item, int date, bool print) {
+  if (item.input_format == "feather") {
+    auto input_file = path_join(item.input_folder, std::to_string(date) + ".feather");
+    return load_feather_data(input_file, "", {}, false, print);
+  } else if (item.input_format == "csv") {
+    auto input_file = path_join(item.input_folder, std::to_string(date) + ".csv");
+    return load_csv_data(input_file, "", {}, false, print);
   }
+  throw std::runtime_error("not support for " + item.input_format);
+}
+
+struct DayJob {
+  int di{0};
+  int date{0};
+  std::shared_ptr<DayData> dd;
+};
+}  // namespace
+
+void LoadDailyDatum(DailyDatum& item, const std::vector<int32_t>& dates, const std::unordered_map<std::string, bool>& ignore_cols, int print_every_n, int load_threads) {
+  Pipeline<DayJob> pipe(2 * std::max(1, load_threads));
+  pipe.stage("load", load_threads, [&](DayJob& job) {
+        bool should_print = print_every_n <= 0 || job.di % print_every_n == 0;
+        job.dd = load_day(item, job.date, should_print);
+      })
+      .sink([&](DayJob& job) { item.m_dds[job.date] = std::move(job.dd); });
+  pipe.run(dates.size(), [&](size_t di) { return DayJob{int(di), dates[di], nullptr}; });
 }
 
 std::shared_ptr<DayData> load_csv_data(const std::string& input_file, const std::string& x_pattern,
@@ -111,6 +123,8 @@ void merge_read(zerg::InputData& m_id, const nlohmann::json& config) {
   check_to(end_date);
   std::string calendar_file = zerg::json_get<std::string>(config, "calendar");
   int print_every_n = zerg::json_get<int>(config, "print_every_n", -1);
+  // dates are read by load_threads threads while the previous ones are merged
+  int load_threads = zerg::json_get<int>(config, "load_threads", 4);
   
   zerg::BizDayConfig biz_day(calendar_file);
   std::vector<int32_t> trading_dates = biz_day.bizDayRange(start_date, end_date);
@@ -157,15 +171,17 @@ void merge_read(zerg::InputData& m_id, const nlohmann::json& config) {
     d_datum.use_prev_date_data = false;
     d_datum.nday = trading_dates.size();
     d_datum.input_format = zerg::json_get<std::string>(entry, "data_type", "feather");
-    zerg::LoadDailyDatum(d_datum, trading_dates, ignore_cols, print_every_n);
     
     int start_col_idx = feat_names.size();
     bool first_date = true;
-    for (int32_t date : trading_dates) {
-      if (d_datum.m_dds.find(date) == d_datum.m_dds.end()) {
-        ZLOG_THROW("cannot find %d for entry %s", date, d_datum.input_folder.c_str());
-      }
-      std::shared_ptr<zerg::DayData>& dd_ = d_datum.m_dds[date];
+    Pipeline<DayJob> pipe(2 * std::max(1, load_threads));
+    pipe.stage("load", load_threads, [&](DayJob& job) {
+      bool should_print = print_every_n <= 0 || job.di % print_every_n == 0;
+      job.dd = load_day(d_datum, job.date, should_print);
+    });
+    pipe.sink([&](DayJob& job) {
+      int32_t date = job.date;
+      std::shared_ptr<zerg::DayData>& dd_ = job.dd;
       size_t curr_len = dd_->x_dates->size();
       
       if (first_entry) {
@@ -266,7 +282,8 @@ void merge_read(zerg::InputData& m_id, const nlohmann::json& config) {
       }
 
       first_date = false;
-    } // end date loop
+    });  // end date sink
+    pipe.run(trading_dates.size(), [&](size_t di) { return DayJob{int(di), trading_dates[di], nullptr}; });
 
     first_entry = false;
   }
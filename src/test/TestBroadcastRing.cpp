@@ -0,0 +1,73 @@
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+#include "zerg/algo/BroadcastRing.h"
+
+using namespace zerg;
+using namespace std;
+
+TEST_CASE("broadcast ring single thread", "[BroadcastRing]") {
+    BroadcastRing<int> ring(3);
+    REQUIRE(ring.capacity() == 4);
+    auto* c1 = ring.add_consumer();
+    auto* c2 = ring.add_consumer();
+
+    for (int i = 0; i < 4; ++i) REQUIRE(ring.try_push(i));
+    REQUIRE_FALSE(ring.try_push(4));  // gated by the slowest consumer
+
+    int sum1 = 0;
+    REQUIRE(c1->poll([&](const int& v, int64_t) { sum1 += v; }) == 4);
+    REQUIRE(sum1 == 6);
+    REQUIRE_FALSE(ring.try_push(4));  // c2 still holds all slots
+
+    std::vector<int64_t> seqs;
+    REQUIRE(c2->poll([&](const int&, int64_t seq) { seqs.push_back(seq); }) == 4);
+    REQUIRE(seqs == std::vector<int64_t>{0, 1, 2, 3});
+    REQUIRE(ring.try_push(4));
+    REQUIRE(c1->poll([](const int&, int64_t) {}) == 1);
+}
+
+TEST_CASE("broadcast ring dependency chain", "[BroadcastRing]") {
+    const int n = 100000;
+    BroadcastRing<int64_t, SpinYieldWait> ring(64);
+    auto* a = ring.add_consumer();
+    auto* b = ring.add_consumer({a});
+    auto* c = ring.add_consumer();
+
+    std::vector<int64_t> a_seen(n, -1);
+    int64_t sum_b = 0, sum_c = 0;
+    bool b_after_a = true;
+
+    std::thread ta([&] {
+        int64_t done = 0;
+        while (done < n) done += a->wait_and_poll([&](const int64_t& v, int64_t seq) { a_seen[seq] = v; });
+    });
+    std::thread tb([&] {
+        int64_t done = 0;
+        while (done < n) {
+            done += b->wait_and_poll([&](const int64_t& v, int64_t seq) {
+                b_after_a = b_after_a && a_seen[seq] == v;
+                sum_b += v;
+            });
+        }
+    });
+    std::thread tc([&] {
+        int64_t done = 0;
+        while (done < n) done += c->wait_and_poll([&](const int64_t& v, int64_t) { sum_c += v; });
+    });
+
+    for (int64_t i = 0; i < n; ++i) {
+        int64_t seq;
+        ring.claim(seq) = i;
+        ring.publish(seq);
+    }
+    ta.join();
+    tb.join();
+    tc.join();
+
+    int64_t expected = (int64_t)n * (n - 1) / 2;
+    REQUIRE(b_after_a);
+    REQUIRE(sum_b == expected);
+    REQUIRE(sum_c == expected);
+    REQUIRE(ring.cursor() == n - 1);
+}
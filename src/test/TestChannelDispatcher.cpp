@@ -0,0 +1,147 @@
+#include <unistd.h>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "zerg/tool/channel_dispatcher.h"
+#include "zerg/tool/event_loop.h"
+
+using namespace zerg;
+using namespace std;
+
+namespace {
+struct Tick {
+    int64_t px;
+    int32_t qty;
+    int32_t pad;
+};
+
+struct Trade {
+    int64_t id;
+};
+
+template <typename T>
+void publish(Channel* ch, uint16_t type, int64_t seq, const T& v) {
+    char buf[sizeof(ShmMsgHeader) + sizeof(T)];
+    auto* h = reinterpret_cast<ShmMsgHeader*>(buf);
+    h->msg_type = type;
+    h->msg_len = sizeof(buf);
+    h->timestamp = 0;
+    h->seq_num = seq;
+    memcpy(h + 1, &v, sizeof(T));
+    ch->PublishVar(buf);
+}
+
+const char* kName = "zerg_test_dispatcher";
+}  // namespace
+
+TEST_CASE("ChannelDispatcher routes by msg_type", "[ChannelDispatcher]") {
+    unlink((string("/tmp/") + kName).c_str());
+    ChannelMgr pub_mgr("/tmp/", 20240102);
+    ChannelMgr sub_mgr("/tmp/", 20240102);
+    Channel* pub = pub_mgr.RegisterPublisherVar(kName, 4096);
+    ChannelDispatcher d(sub_mgr.RegisterSubscriber(kName));
+
+    vector<int64_t> ticks, trades;
+    vector<int64_t> tick_seqs;
+    vector<uint16_t> others;
+    d.on<Tick>(1, [&](const Tick& t, const ShmMsgHeader& h) {
+        ticks.push_back(t.px * t.qty);
+        tick_seqs.push_back(h.seq_num);
+    });
+    d.on<Trade>(300, [&](const Trade& t) { trades.push_back(t.id); });
+    d.on_unhandled([&](const ShmMsgHeader& h) { others.push_back(h.msg_type); });
+    REQUIRE(d.has_handler(1));
+    REQUIRE_FALSE(d.has_handler(2));
+    REQUIRE(d.poll() == 0);
+
+    int64_t seq = 0;
+    publish(pub, 1, seq++, Tick{10, 2, 0});
+    publish(pub, 300, seq++, Trade{77});
+    publish(pub, 5, seq++, Trade{1});
+    publish(pub, 1, seq++, Tick{3, 3, 0});
+    REQUIRE(d.poll(3) == 3);
+    REQUIRE(d.poll() == 1);
+    REQUIRE(d.index() == 3);
+
+    REQUIRE(ticks == vector<int64_t>{20, 9});
+    REQUIRE(tick_seqs == vector<int64_t>{0, 3});
+    REQUIRE(trades == vector<int64_t>{77});
+    REQUIRE(others == vector<uint16_t>{5});
+    REQUIRE(d.stats().dispatched == 3);
+    REQUIRE(d.stats().unhandled == 1);
+
+    SECTION("short payload is dropped") {
+        publish(pub, 1, seq++, Trade{5});  // 8 bytes where a Tick needs 16
+        REQUIRE(d.poll() == 1);
+        REQUIRE(d.stats().malformed == 1);
+        REQUIRE(ticks.size() == 2);
+    }
+
+    SECTION("off and EventBus routing") {
+        d.off(300);
+        publish(pub, 300, seq++, Trade{78});
+        REQUIRE(d.poll() == 1);
+        REQUIRE(others.back() == 300);
+
+        EventBus bus;
+        int64_t sum = 0;
+        bus.subscribe(300, std::function<void(const Trade&)>([&](const Trade& t) { sum += t.id; }));
+        d.route_to<Trade>(300, bus);
+        publish(pub, 300, seq++, Trade{5});
+        publish(pub, 300, seq++, Trade{6});
+        BackoffWait waiter;
+        REQUIRE(d.wait_poll(waiter) == 2);
+        REQUIRE(sum == 11);
+    }
+    unlink((string("/tmp/") + kName).c_str());
+}
+
+TEST_CASE("ChannelDispatcher follows a warped channel", "[ChannelDispatcher]") {
+    unlink((string("/tmp/") + kName).c_str());
+    ChannelMgr pub_mgr("/tmp/", 20240102);
+    ChannelMgr sub_mgr("/tmp/", 20240102);
+    // room for 4 ticks, the 5th wraps to the start
+    Channel* pub = pub_mgr.RegisterPublisherVar(kName, 4 * (sizeof(ShmMsgHeader) + sizeof(Tick)) + 8);
+    ChannelDispatcher d(sub_mgr.RegisterSubscriber(kName));
+    vector<int64_t> px;
+    d.on<Tick>(1, [&](const Tick& t) { px.push_back(t.px); });
+
+    int64_t seq = 0;
+    for (int i = 0; i < 3; ++i, ++seq) publish(pub, 1, seq, Tick{seq + 1, 1, 0});
+    REQUIRE(d.poll() == 3);
+    for (int i = 0; i < 3; ++i, ++seq) publish(pub, 1, seq, Tick{seq + 1, 1, 0});
+    REQUIRE(d.poll() == 3);
+    REQUIRE(px == vector<int64_t>{1, 2, 3, 4, 5, 6});
+    unlink((string("/tmp/") + kName).c_str());
+}
+
+TEST_CASE("ChannelDispatcher and EventLoop share the channel cursor", "[ChannelDispatcher]") {
+    unlink((string("/tmp/") + kName).c_str());
+    ChannelMgr pub_mgr("/tmp/", 20240102);
+    ChannelMgr sub_mgr("/tmp/", 20240102);
+    Channel* pub = pub_mgr.RegisterPublisherVar(kName, 2 * (sizeof(ShmMsgHeader) + sizeof(Tick)));
+    Channel* sub = sub_mgr.RegisterSubscriber(kName);
+    ChannelDispatcher d(sub);
+    vector<int64_t> px;
+    d.on<Tick>(1, [&](const Tick& t) { px.push_back(t.px); });
+
+    EventLoop loop;
+    vector<int64_t> seqs;
+    loop.add_channel_var(sub, [&](const ShmMsgHeader* h) { seqs.push_back(h->seq_num); });
+
+    publish(pub, 1, 0, Tick{10, 1, 0});
+    publish(pub, 1, 1, Tick{11, 1, 0});
+    REQUIRE(loop.run_once() == 2);
+    REQUIRE(seqs == vector<int64_t>{0, 1});
+
+    // no warp and an index beyond the data: the next message can not be located, reported not skipped
+    pub->pcb->warp = 0;
+    __atomic_add_fetch(&pub->pcb->curr_idx, 1, __ATOMIC_RELEASE);
+    REQUIRE_THROWS_AS(d.poll(), std::runtime_error);
+    REQUIRE(px == vector<int64_t>{10, 11});
+    REQUIRE(d.index() == 1);
+    REQUIRE_THROWS_AS(loop.run_once(), std::runtime_error);
+    unlink((string("/tmp/") + kName).c_str());
+}
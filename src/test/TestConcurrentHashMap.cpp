@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+#include "zerg/algo/ConcurrentHashMap.h"
+
+using namespace zerg;
+using namespace std;
+
+TEST_CASE("concurrent hash map basic", "[ConcurrentHashMap]") {
+    ConcurrentHashMap<int, int64_t> m(4);
+    REQUIRE(m.empty());
+    REQUIRE(m.insert(1, 10));
+    REQUIRE_FALSE(m.insert(1, 11));
+    REQUIRE(m.get(1) == 10);
+    REQUIRE_FALSE(m.insert_or_assign(1, 12));
+    REQUIRE(m.get(1) == 12);
+    REQUIRE(m.get(2, -1) == -1);
+
+    for (int i = 2; i < 1000; ++i) REQUIRE(m.insert(i, i * 10));
+    REQUIRE(m.size() == 999);
+    REQUIRE(m.capacity() >= 2000);
+    for (int i = 2; i < 1000; ++i) REQUIRE(m.get(i) == i * 10);
+
+    REQUIRE(m.erase(5));
+    REQUIRE_FALSE(m.erase(5));
+    REQUIRE_FALSE(m.contains(5));
+    REQUIRE(m.size() == 998);
+    REQUIRE(m.insert(5, 55));  // revive tombstone
+    REQUIRE(m.get(5) == 55);
+
+    int64_t sum = 0;
+    m.for_each([&](const int&, int64_t v) { sum += v; });
+    REQUIRE(sum == 12 + 55 + (999 * 1000 / 2 - 1 - 5) * 10);
+}
+
+TEST_CASE("concurrent hash map readers during inserts and resize", "[ConcurrentHashMap]") {
+    ConcurrentHashMap<int64_t, int64_t> m(16);
+    const int writers = 3, per_writer = 20000;
+    std::atomic<bool> stop{false};
+    std::atomic<bool> ok{true};
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; ++t) {
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                for (int64_t k = 0; k < writers * per_writer; k += 97) {
+                    int64_t v;
+                    if (m.find(k, v) && v != k * 3) ok = false;
+                }
+            }
+        });
+    }
+    std::vector<std::thread> ws;
+    for (int t = 0; t < writers; ++t) {
+        ws.emplace_back([&, t] {
+            for (int64_t i = 0; i < per_writer; ++i) {
+                int64_t k = i * writers + t;
+                m.insert(k, k * 3);
+                m.insert_or_assign(i, i * 3);  // all writers race on the same keys
+            }
+        });
+    }
+    for (auto& t : ws) t.join();
+    stop = true;
+    for (auto& t : readers) t.join();
+
+    REQUIRE(ok);
+    REQUIRE(m.size() == (size_t)writers * per_writer);
+    bool all = true;
+    for (int64_t k = 0; k < writers * per_writer; ++k) all = all && m.get(k, -1) == k * 3;
+    REQUIRE(all);
+}
+
+TEST_CASE("concurrent hash map churn does not retain tables", "[ConcurrentHashMap]") {
+    ConcurrentHashMap<int64_t, int64_t> m(64);
+    for (int64_t k = 0; k < 100; ++k) REQUIRE(m.get(k, -1) == -1);  // this thread holds a reader handle
+    for (int64_t k = 0; k < 100; ++k) m.insert(k, k);
+    int64_t next = 1000;
+    auto churn = [&](int64_t n) {
+        size_t most = 0;
+        for (int64_t i = 0; i < n; ++i, ++next) {
+            m.insert(next, next);
+            m.erase(next);
+            if (i % 1000 == 0) most = std::max(most, m.retained_capacity());
+        }
+        return most;
+    };
+
+    // the tombstones force same size rebuilds, each replaced table is freed two rebuilds later
+    REQUIRE(churn(1000000) <= 4 * m.capacity());
+
+    // a reader pinned while the writer churns only delays freeing
+    std::atomic<bool> stop{false};
+    std::atomic<bool> ok{true};
+    std::thread reader([&] {
+        while (!stop.load()) {
+            for (int64_t k = 0; k < 100; ++k) {
+                if (m.get(k, -1) != k) ok = false;
+            }
+        }
+    });
+    churn(200000);
+    stop = true;
+    reader.join();
+    REQUIRE(ok);
+    churn(10000);
+    REQUIRE(m.retained_capacity() <= 4 * m.capacity());
+    REQUIRE(m.size() == 100);
+}
@@ -0,0 +1,95 @@
+#include "zerg/tool/coro.h"
+
+#ifdef ZERG_HAS_COROUTINES
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+#include "zerg/tool/thread_pool.h"
+#include "zerg/tool/work_stealing_pool.h"
+
+using namespace zerg;
+using namespace std;
+
+static Task<int> add_one(int v) { co_return v + 1; }
+
+static Task<int> chain(int depth) {
+    int v = 0;
+    for (int i = 0; i < depth; ++i) v = co_await add_one(v);
+    co_return v;
+}
+
+TEST_CASE("coroutine task basics", "[coro]") {
+    REQUIRE(sync_wait(add_one(41)) == 42);
+    REQUIRE(sync_wait(chain(100000)) == 100000);  // symmetric transfer, no stack growth
+
+    auto fail = []() -> Task<void> {
+        throw std::runtime_error("boom");
+        co_return;
+    };
+    REQUIRE_THROWS_AS(sync_wait(fail()), std::runtime_error);
+}
+
+TEST_CASE("coroutine tasks run on pools", "[coro]") {
+    ThreadPool pool(3);
+    auto caller = std::this_thread::get_id();
+    auto on_pool = [&]() -> Task<bool> {
+        co_await schedule_on(pool);
+        co_return std::this_thread::get_id() != caller;
+    };
+    REQUIRE(sync_wait(on_pool()));
+
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+    std::vector<Task<int>> loads;
+    for (int i = 0; i < 20; ++i) {
+        loads.push_back(async_run(pool, [&, i] {
+            int r = ++running;
+            int p = peak.load();
+            while (r > p && !peak.compare_exchange_weak(p, r)) {
+            }
+            usleep(2000);
+            --running;
+            return i * i;
+        }));
+    }
+    auto results = sync_wait(when_all(std::move(loads)));
+    REQUIRE(results.size() == 20);
+    for (int i = 0; i < 20; ++i) REQUIRE(results[i] == i * i);
+    REQUIRE(peak <= 3);
+
+    WorkStealingPool ws(2);
+    std::atomic<int> count{0};
+    std::vector<Task<void>> jobs;
+    for (int i = 0; i < 10; ++i) {
+        jobs.push_back(async_run(ws, [&] { ++count; }));
+    }
+    jobs.push_back(async_run(ws, [] { throw std::logic_error("bad file"); }));
+    REQUIRE_THROWS_AS(sync_wait(when_all(std::move(jobs))), std::logic_error);
+    REQUIRE(count == 10);
+    REQUIRE(sync_wait(when_all(std::vector<Task<int>>{})).empty());
+}
+
+TEST_CASE("coroutine reads from fds", "[coro]") {
+    FdPoller poller;
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    std::thread writer([&] {
+        usleep(20000);
+        ssize_t ret = write(fds[1], "ping", 4);
+        (void)ret;
+    });
+    char buf[16];
+    ssize_t n = sync_wait(async_read(poller, fds[0], buf, sizeof(buf)));
+    writer.join();
+    REQUIRE(n == 4);
+    REQUIRE(std::string(buf, 4) == "ping");
+    close(fds[0]);
+    close(fds[1]);
+}
+#endif
@@ -1,7 +1,12 @@
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 #include "catch.hpp"
 #include "zerg/algo/dag.h"
+#include "zerg/algo/dag_executor.h"
+#include "zerg/tool/thread_pool.h"
 
 using namespace std;
 
@@ -28,3 +33,146 @@ TEST_CASE("topo sort", "[DependencyTree]") {
     std::vector<size_t> target{3, 0, 2, 1, 4, 5, 6};
     REQUIRE(sorted == target);
 }
+
+TEST_CASE("dag executor runs dependencies first", "[DependencyTree]") {
+    // layered graph: every node of layer k depends on two nodes of layer k-1
+    const int layers = 50, width = 40;
+    zerg::DAG<int> dag;
+    std::vector<int> values(layers * width);
+    for (auto& v : values) dag.AddNode(&v);
+    for (int k = 1; k < layers; ++k) {
+        for (int i = 0; i < width; ++i) {
+            dag.AddDependency(k * width + i, (k - 1) * width + i);
+            dag.AddDependency(k * width + i, (k - 1) * width + (i + 1) % width);
+        }
+    }
+    zerg::DagExecutor<int> exec(dag);
+    REQUIRE(exec.order().size() == values.size());
+    zerg::ThreadPool pool(4);
+    std::vector<std::atomic<int>> finished(values.size());
+    std::atomic<int> violations{0};
+    exec.run(pool, [&](size_t id, int* p) {
+        if (id >= width) {
+            size_t k = id / width, i = id % width;
+            if (!finished[(k - 1) * width + i] || !finished[(k - 1) * width + (i + 1) % width]) ++violations;
+        }
+        *p = 1;
+        finished[id] = 1;
+    });
+    REQUIRE(violations == 0);
+    REQUIRE(std::count(values.begin(), values.end(), 1) == layers * width);
+    REQUIRE(exec.critical_path().size() == layers);
+    REQUIRE(exec.report(3).find("critical path") != std::string::npos);
+}
+
+TEST_CASE("dag executor deep chain and cycle", "[DependencyTree]") {
+    const size_t n = 20000;
+    zerg::DAG<int> dag;
+    std::vector<int> dummy(n);
+    for (size_t i = 0; i < n; ++i) dag.AddNode(&dummy[i]);
+    for (size_t i = 1; i < n; ++i) dag.AddDependency(i, i - 1);
+    zerg::DagExecutor<int> exec(dag);
+    zerg::ThreadPool pool(2);
+    size_t next = 0;
+    bool in_order = true;
+    exec.run(pool, [&](size_t id, int*) { in_order = in_order && id == next++; });
+    REQUIRE(in_order);
+    REQUIRE(next == n);
+    REQUIRE(exec.critical_path().size() == n);
+
+    REQUIRE_THROWS_AS(exec.run(pool, [](size_t id, int*) {
+        if (id == 10) throw std::runtime_error("bad feature");
+    }), std::runtime_error);
+
+    dag.AddDependency(0, n - 1);
+    REQUIRE_THROWS_AS(zerg::DagExecutor<int>(dag), std::invalid_argument);
+}
+
+TEST_CASE("topo sort cycles and levels", "[DependencyTree]") {
+    // deep chain, the recursive sort used to overflow the stack here
+    const size_t n = 200000;
+    zerg::DAG<int> chain;
+    std::vector<int> dummy(n);
+    for (size_t i = 0; i < n; ++i) chain.AddNode(&dummy[i]);
+    for (size_t i = 1; i < n; ++i) chain.AddDependency(i, i - 1);
+    chain.Sort();
+    REQUIRE(chain.getSortedList().front() == 0);
+    REQUIRE(chain.GetLevels().size() == n);
+
+    zerg::DAG<int> dag;
+    int v[5];
+    for (auto& x : v) dag.AddNode(&x);
+    dag.AddDependency(2, 0);
+    dag.AddDependency(2, 1);
+    dag.AddDependency(3, 2);
+    dag.AddDependency(4, 1);
+    REQUIRE(dag.AddDependency(5, 0) == -1);
+    dag.Sort();
+    auto& levels = dag.GetLevels();
+    REQUIRE(levels.size() == 3);
+    REQUIRE(levels[0] == std::vector<size_t>{0, 1});
+    REQUIRE(levels[1] == std::vector<size_t>{2, 4});
+    REQUIRE(levels[2] == std::vector<size_t>{3});
+
+    dag.AddDependency(1, 3);
+    try {
+        dag.Sort();
+        FAIL("cycle accepted");
+    } catch (const std::invalid_argument& e) {
+        REQUIRE(std::string(e.what()).find("1 -> 3 -> 2 -> 1") != std::string::npos);
+    }
+}
+
+TEST_CASE("dag incremental recompute", "[DependencyTree]") {
+    // 0 -> 2 -> 3, 1 -> 2, 1 -> 4, 5 alone
+    zerg::DAG<int> dag;
+    int v[6];
+    for (auto& x : v) dag.AddNode(&x);
+    dag.AddDependency(2, 0);
+    dag.AddDependency(2, 1);
+    dag.AddDependency(3, 2);
+    dag.AddDependency(4, 1);
+    dag.Sort();
+
+    std::vector<size_t> ran;
+    dag.MarkDirty(0);
+    REQUIRE(dag.IsDirty(0));
+    REQUIRE(dag.Recompute([&](size_t id, int*) { ran.push_back(id); }) == 3);
+    REQUIRE(ran == std::vector<size_t>{0, 2, 3});
+    REQUIRE_FALSE(dag.IsDirty(0));
+    REQUIRE(dag.Recompute([&](size_t, int*) { FAIL("nothing is dirty"); }) == 0);
+
+    std::vector<std::vector<size_t>> batches;
+    dag.MarkDirty(1);
+    dag.MarkDirty(2);
+    REQUIRE(dag.RecomputeLevels([&](const std::vector<size_t>& ids) { batches.push_back(ids); }) == 4);
+    REQUIRE(batches.size() == 3);
+    REQUIRE(batches[0] == std::vector<size_t>{1});
+    REQUIRE(batches[1] == std::vector<size_t>{2, 4});
+    REQUIRE(batches[2] == std::vector<size_t>{3});
+
+    dag.MarkAllDirty();
+    REQUIRE(dag.Affected().size() == 6);
+}
+
+TEST_CASE("dag edge added after sort", "[DependencyTree]") {
+    // 0 -> 1, then 2 -> 0 and 3 -> 2 are added once sorted
+    zerg::DAG<int> dag;
+    int v[4];
+    for (auto& x : v) dag.AddNode(&x);
+    dag.AddDependency(1, 0);
+    dag.Sort();
+    dag.MarkDirty(3);  // survives the re-sort below
+
+    dag.AddDependency(0, 2);
+    dag.AddDependency(2, 3);
+    std::vector<size_t> ran;
+    REQUIRE(dag.Recompute([&](size_t id, int*) { ran.push_back(id); }) == 4);
+    REQUIRE(ran == std::vector<size_t>{3, 2, 0, 1});
+    REQUIRE(dag.GetDependents(2) == std::vector<size_t>{0});
+    REQUIRE(dag.GetLevels().size() == 4);
+
+    // a cycle closed after sort is reported on the next use
+    dag.AddDependency(3, 1);
+    REQUIRE_THROWS_AS(dag.MarkDirty(0), std::invalid_argument);
+}
@@ -0,0 +1,92 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+#include "zerg/tool/epoch.h"
+
+using namespace zerg;
+using namespace std;
+
+namespace {
+std::atomic<int64_t> g_alive{0};
+
+struct Node {
+    explicit Node(int64_t v_) : v(v_), check(~v_) { ++g_alive; }
+    ~Node() {
+        check = 0;
+        v = -1;
+        --g_alive;
+    }
+    int64_t v;
+    int64_t check;
+};
+}  // namespace
+
+TEST_CASE("epoch reclaim waits for readers", "[epoch]") {
+    {
+        EpochDomain domain;
+        auto* reader = domain.register_thread();
+        auto* writer = domain.register_thread();
+
+        Node* n = new Node(1);
+        reader->enter();
+        writer->retire(n);
+        for (int i = 0; i < 10; ++i) writer->reclaim();
+        REQUIRE(writer->pending() == 1);  // reader pins the epoch
+        REQUIRE(n->check == ~int64_t(1));
+        reader->exit();
+
+        REQUIRE(domain.epoch() == 1);  // reader entered in epoch 0 only lets it advance once
+        REQUIRE(writer->reclaim() == 0);
+        REQUIRE(g_alive == 0);
+
+        writer->retire(new Node(2));
+        domain.unregister_thread(writer);  // leftover goes to domain
+        domain.unregister_thread(reader);
+        REQUIRE(domain.register_thread() != nullptr);  // handle reused
+    }
+    REQUIRE(g_alive == 0);
+}
+
+TEST_CASE("epoch concurrent retire and read", "[epoch]") {
+    {
+        EpochDomain domain;
+        std::atomic<Node*> shared{new Node(0)};
+        std::atomic<bool> stop{false};
+        std::atomic<bool> ok{true};
+
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 3; ++t) {
+            readers.emplace_back([&] {
+                auto* h = domain.register_thread();
+                while (!stop.load(std::memory_order_relaxed)) {
+                    EpochGuard g(*h);
+                    Node* n = shared.load(std::memory_order_acquire);
+                    if (n->check != ~n->v) ok = false;
+                }
+                domain.unregister_thread(h);
+            });
+        }
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 2; ++t) {
+            writers.emplace_back([&, t] {
+                auto* h = domain.register_thread();
+                for (int64_t i = 1; i <= 20000; ++i) {
+                    Node* old = shared.exchange(new Node(i * 2 + t), std::memory_order_acq_rel);
+                    h->retire(old);
+                }
+                domain.unregister_thread(h);
+            });
+        }
+        for (auto& t : writers) t.join();
+        stop = true;
+        for (auto& t : readers) t.join();
+        REQUIRE(ok);
+        domain.reclaim_orphans();
+        domain.reclaim_orphans();
+        REQUIRE(domain.reclaim_orphans() == 0);
+        REQUIRE(g_alive == 1);
+        delete shared.load();
+    }
+    REQUIRE(g_alive == 0);
+}
@@ -0,0 +1,154 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "catch.hpp"
+#include "zerg/tool/event_bus.h"
+
+using namespace zerg;
+using namespace std;
+
+namespace {
+using QuoteCb = std::function<void(const string&, int)>;
+
+void wait_until(const std::function<bool()>& done) {
+    for (int i = 0; i < 5000 && !done(); ++i) this_thread::sleep_for(chrono::milliseconds(1));
+}
+}  // namespace
+
+TEST_CASE("EventBus sync", "[EventBus]") {
+    EventBus bus;
+    int sum = 0;
+    bus.subscribe(1, QuoteCb([&](const string&, int px) { sum += px; }));
+    bus.fire_event<QuoteCb>(1, string("a"), 3);
+    bus.fire_event<QuoteCb>(1, string("a"), 4);
+    REQUIRE(sum == 7);
+    REQUIRE_THROWS(bus.subscribe(1, std::function<void(int)>([](int) {})));
+}
+
+TEST_CASE("EventBus async Block delivers everything in order", "[EventBus]") {
+    EventBus bus;
+    vector<int> seen;
+    string last_sym;
+    AsyncSubscriberOptions opt;
+    opt.name = "recorder";
+    opt.capacity = 16;
+    opt.overflow = OverflowPolicy::Block;
+    bus.subscribe_async(1, QuoteCb([&](const string& sym, int px) {
+                            last_sym = sym;
+                            seen.push_back(px);
+                        }),
+                        opt);
+    for (int i = 0; i < 1000; ++i) bus.fire_event<QuoteCb>(1, string("IF"), i);
+    wait_until([&] { return bus.async_stats()[0].delivered == 1000; });
+
+    auto stats = bus.async_stats();
+    REQUIRE(stats.size() == 1);
+    REQUIRE(stats[0].name == "recorder");
+    REQUIRE(stats[0].event_type == 1);
+    REQUIRE(stats[0].published == 1000);
+    REQUIRE(stats[0].delivered == 1000);
+    REQUIRE(stats[0].dropped == 0);
+    REQUIRE(stats[0].lag.count == 1000);
+    REQUIRE(last_sym == "IF");
+    REQUIRE(seen.size() == 1000);
+    for (int i = 0; i < 1000; ++i) REQUIRE(seen[i] == i);
+}
+
+TEST_CASE("EventBus slow async subscriber does not stall the publisher", "[EventBus]") {
+    EventBus bus;
+    atomic<bool> release{false};
+    atomic<int> slow_calls{0};
+    int fast_sum = 0;
+    AsyncSubscriberOptions opt;
+    opt.capacity = 4;
+    bus.subscribe_async(7, QuoteCb([&](const string&, int) {
+                            while (!release.load()) this_thread::sleep_for(chrono::microseconds(100));
+                            ++slow_calls;
+                        }),
+                        opt);
+    bus.subscribe(7, QuoteCb([&](const string&, int px) { fast_sum += px; }));
+
+    for (int i = 0; i < 100; ++i) bus.fire_event<QuoteCb>(7, string("x"), 1);
+    REQUIRE(fast_sum == 100);  // inline subscriber saw everything while the async one is stuck
+
+    auto stats = bus.async_stats()[0];
+    REQUIRE(stats.published == 100);
+    REQUIRE(stats.dropped >= 100 - 5);  // the one being handled plus a full queue
+    REQUIRE_FALSE(stats.disconnected);
+
+    release = true;
+    wait_until([&] {
+        auto s = bus.async_stats()[0];
+        return s.delivered + s.dropped == s.published;
+    });
+    stats = bus.async_stats()[0];
+    REQUIRE(static_cast<uint64_t>(slow_calls.load()) == stats.delivered);
+    REQUIRE(stats.delivered + stats.dropped == 100);
+}
+
+TEST_CASE("EventBus async Disconnect stops at the first overflow", "[EventBus]") {
+    EventBus bus;
+    atomic<bool> release{false};
+    AsyncSubscriberOptions opt;
+    opt.capacity = 2;
+    opt.overflow = OverflowPolicy::Disconnect;
+    bus.subscribe_async(2, QuoteCb([&](const string&, int) {
+                            while (!release.load()) this_thread::sleep_for(chrono::microseconds(100));
+                        }),
+                        opt);
+    for (int i = 0; i < 20; ++i) bus.fire_event<QuoteCb>(2, string("x"), i);
+    release = true;
+    wait_until([&] {
+        auto s = bus.async_stats()[0];
+        return s.delivered + s.dropped == s.published;
+    });
+    auto stats = bus.async_stats()[0];
+    REQUIRE(stats.disconnected);
+    REQUIRE(stats.delivered <= 3);
+    REQUIRE(stats.delivered + stats.dropped == 20);
+}
+
+TEST_CASE("EventBus async copies reference arguments", "[EventBus]") {
+    using AdjustCb = std::function<void(int&)>;
+    atomic<int> got{0};
+    {
+        EventBus bus;
+        AsyncSubscriberOptions opt;
+        opt.overflow = OverflowPolicy::Block;
+        bus.subscribe_async(3, AdjustCb([&](int& v) {
+                                got = v;
+                                v = -1;  // only the queued copy changes
+                            }),
+                            opt);
+        int value = 42;
+        bus.fire_event<AdjustCb>(3, value);
+        wait_until([&] { return bus.async_stats()[0].delivered == 1; });
+        REQUIRE(value == 42);
+    }  // destructor drains and joins
+    REQUIRE(got == 42);
+}
+
+TEST_CASE("EventBus async subscriber core is checked when subscribing", "[EventBus]") {
+    EventBus bus;
+    AsyncSubscriberOptions opt;
+    opt.core = 4000;
+    REQUIRE_THROWS_AS(bus.subscribe_async(4, QuoteCb([](const string&, int) {}), opt), std::invalid_argument);
+    REQUIRE(bus.async_stats().empty());
+
+    atomic<int> sum{0};
+    opt.core = static_cast<int>(GetAffinity().front());
+    bus.subscribe_async(4, QuoteCb([&](const string&, int px) { sum += px; }), opt);
+    bus.fire_event<QuoteCb>(4, string("a"), 5);
+    wait_until([&] { return sum == 5; });
+    REQUIRE(sum == 5);
+}
+
+TEST_CASE("EventBus async subscriber with the wrong signature starts nothing", "[EventBus]") {
+    EventBus bus;
+    bus.subscribe(5, QuoteCb([](const string&, int) {}));
+    REQUIRE_THROWS_AS(bus.subscribe_async(5, std::function<void(int)>([](int) {})), std::runtime_error);
+    REQUIRE(bus.async_stats().empty());
+    bus.subscribe_async(5, QuoteCb([](const string&, int) {}));
+    REQUIRE(bus.async_stats().size() == 1);
+}
@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include "catch.hpp"
+#include "zerg/tool/latency_thread.h"
+#include "zerg/unix.h"
+
+using namespace zerg;
+using namespace std;
+
+thread_local char tls_buffer[1 << 16];
+
+TEST_CASE("latency thread setup", "[latency thread]") {
+    LatencyThreadConfig cfg;
+    cfg.name = "md-feed";
+    cfg.core = static_cast<int>(GetOnlineCpus().front());
+    cfg.rt_priority = 10;  // only logged when not permitted
+    cfg.calibrate_ms = 20;
+    bool prefaulted = false;
+    cfg.prefault = [&] {
+        for (size_t i = 0; i < sizeof(tls_buffer); i += 4096) tls_buffer[i] = 1;
+        prefaulted = true;
+    };
+    std::atomic<int> ran{0};
+    pthread_t self{};
+    LatencyThread t = spawn_latency_thread(cfg, [&] {
+        self = pthread_self();
+        ++ran;
+    });
+    REQUIRE(prefaulted);
+    const auto& report = t.report();
+    REQUIRE(report.pinned);
+    REQUIRE(report.core == cfg.core);
+    REQUIRE(report.jitter.count > 0);
+    REQUIRE(report.jitter.percentile(0.5) <= report.jitter.max);
+    REQUIRE(!report.to_string().empty());
+    t.join();
+    REQUIRE(ran == 1);
+    REQUIRE(pthread_equal(self, t.native_handle()));
+    REQUIRE_FALSE(t.joinable());
+}
+
+TEST_CASE("latency thread setup errors", "[latency thread]") {
+    LatencyThreadConfig cfg;
+    cfg.core = 1 << 20;  // no such cpu
+    cfg.calibrate_ms = 0;
+    bool ran = false;
+    REQUIRE_THROWS_AS(spawn_latency_thread(cfg, [&] { ran = true; }), std::runtime_error);
+    REQUIRE_FALSE(ran);
+
+    auto isolated = GetIsolatedCpus();
+    auto online = GetOnlineCpus();
+    for (size_t cpu : online) {
+        if (std::find(isolated.begin(), isolated.end(), cpu) != isolated.end()) continue;
+        cfg.core = static_cast<int>(cpu);
+        cfg.require_isolated = true;
+        REQUIRE_THROWS_AS(spawn_latency_thread(cfg, [] {}), std::runtime_error);
+        break;
+    }
+}
@@ -1,5 +1,9 @@
+#include <set>
+#include <thread>
 #include "catch.hpp"
+#include "zerg/algo/SpscQueue.h"
 #include "zerg/tool/mem_pool.h"
+#include "zerg/tool/wait_strategy.h"
 
 using namespace zerg;
 using namespace std;
@@ -193,3 +197,188 @@ TEST_CASE("mem pool TestData size requirement", "[mem pool]") {
     REQUIRE(data != nullptr);
     pool.deallocate(data);
 }
+
+TEST_CASE("concurrent mem pool single thread", "[mem pool]") {
+    ConcurrentMemPool<TestData, 100, 8> pool;
+
+    set<TestData*> live;
+    for (int i = 0; i < 250; ++i) {
+        TestData* data = pool.allocate();
+        REQUIRE(live.insert(data).second);
+        data->a = i;
+    }
+    REQUIRE(pool.capacity() == 300);
+    REQUIRE(pool.slab_count() == 3);
+
+    for (auto* ptr : live) pool.deallocate(ptr);
+    TestData* last = *live.rbegin();
+    REQUIRE(pool.allocate() == last);  // LIFO through the thread cache
+    pool.deallocate(last);
+
+    // everything freed comes back before any new slab
+    vector<TestData*> again;
+    for (int i = 0; i < 250; ++i) again.push_back(pool.allocate());
+    REQUIRE(pool.capacity() == 300);
+    REQUIRE(set<TestData*>(again.begin(), again.end()) == live);
+    for (auto* ptr : again) pool.deallocate(ptr);
+}
+
+TEST_CASE("concurrent mem pool cross thread free", "[mem pool]") {
+    ConcurrentMemPool<TestData, 1000, 16> pool;
+    SpscQueue<TestData*, BlockingWait> q(256);
+    constexpr int64_t N = 100000;
+    int64_t bad = 0;
+
+    std::thread consumer([&] {
+        for (int64_t i = 0; i < N; ++i) {
+            TestData* data = *q.wait_front();
+            q.pop();
+            if (data->a != i || data->b != -i) ++bad;
+            pool.deallocate(data);
+        }
+    });
+    for (int64_t i = 0; i < N; ++i) {
+        TestData* data = pool.allocate();
+        data->a = i;
+        data->b = -i;
+        q.emplace(data);
+    }
+    consumer.join();
+
+    REQUIRE(bad == 0);
+    // at most 256 in the queue plus a few magazines in caches, blocks come back through the depot
+    REQUIRE(pool.capacity() <= 2000);
+    REQUIRE(pool.depot_pops() > 0);
+    REQUIRE(pool.depot_pushes() > 0);
+}
+
+TEST_CASE("concurrent mem pool many threads", "[mem pool]") {
+    ConcurrentMemPool<TestData, 512, 32> pool;
+    constexpr int THREADS = 4;
+    constexpr int LIVE = 300;
+    vector<std::thread> threads;
+    vector<int64_t> bad(THREADS, 0);
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&, t] {
+            vector<TestData*> mine(LIVE);
+            for (int round = 0; round < 200; ++round) {
+                for (int i = 0; i < LIVE; ++i) {
+                    mine[i] = pool.allocate();
+                    mine[i]->a = t;
+                    mine[i]->b = round * LIVE + i;
+                }
+                for (int i = 0; i < LIVE; ++i) {
+                    if (mine[i]->a != t || mine[i]->b != round * LIVE + i) ++bad[t];
+                    pool.deallocate(mine[i]);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    for (int t = 0; t < THREADS; ++t) REQUIRE(bad[t] == 0);
+    // exiting threads flushed their caches, all blocks are reusable here
+    vector<TestData*> all;
+    size_t cap = pool.capacity();
+    for (size_t i = 0; i < cap; ++i) all.push_back(pool.allocate());
+    REQUIRE(pool.capacity() == cap);
+    REQUIRE(set<TestData*>(all.begin(), all.end()).size() == cap);
+    for (auto* ptr : all) pool.deallocate(ptr);
+}
+
+TEST_CASE("concurrent mem pool outlived by threads", "[mem pool]") {
+    auto pool = std::make_unique<ConcurrentMemPool<TestData, 64, 8>>();
+    auto* data = pool->allocate();
+    std::thread([&] { pool->deallocate(data); }).join();
+    pool.reset();  // this thread's cache is now stale
+
+    ConcurrentMemPool<TestData, 64, 8> other;
+    TestData* p = other.allocate();
+    REQUIRE(p != nullptr);
+    other.deallocate(p);
+}
+
+namespace {
+struct Counted {
+    static int constructed;
+    int64_t v{0};
+    Counted() { ++constructed; }
+};
+int Counted::constructed = 0;
+}  // namespace
+
+TEST_CASE("mem pool slabs are raw and aligned", "[mem pool]") {
+    MemPool<Counted, 100> pool(0);
+    REQUIRE(pool.capacity() == 0);
+    Counted* c = pool.allocate();
+    REQUIRE(Counted::constructed == 0);  // no default construction of the slab
+    REQUIRE(pool.capacity() == 100);
+    REQUIRE(reinterpret_cast<uintptr_t>(c) % 8 == 0);
+    pool.deallocate(c);
+
+    MemPool<TestData, 10, 64> aligned(0);
+    REQUIRE(MemPool<TestData, 10, 64>::STRIDE == 64);
+    TestData* a = aligned.allocate();
+    TestData* b = aligned.allocate();
+    REQUIRE(reinterpret_cast<uintptr_t>(a) % 64 == 0);
+    REQUIRE(reinterpret_cast<uintptr_t>(b) % 64 == 0);
+    REQUIRE(a != b);
+    aligned.deallocate(a);
+    aligned.deallocate(b);
+
+    MemPool<char, 10> small(0);  // narrower than the free list link
+    char* x = small.allocate();
+    char* y = small.allocate();
+    REQUIRE(static_cast<size_t>(std::abs(x - y)) >= sizeof(void*));
+    small.deallocate(x);
+    small.deallocate(y);
+}
+
+TEST_CASE("mem pool trim", "[mem pool]") {
+    MemPool<TestData, 4> pool(0);
+    vector<TestData*> ptrs;
+    for (int i = 0; i < 14; ++i) ptrs.push_back(pool.allocate());
+    REQUIRE(pool.slab_count() == 4);
+    REQUIRE(pool.trim() == 0);  // every slab has a live block
+
+    // keep one block of the second slab alive, free everything else
+    TestData* keep = ptrs[5];
+    keep->a = 7;
+    for (auto* p : ptrs) {
+        if (p != keep) pool.deallocate(p);
+    }
+    REQUIRE(pool.trim() == 3 * pool.slab_bytes());
+    REQUIRE(pool.slab_count() == 1);
+    REQUIRE(pool.capacity() == 4);
+    REQUIRE(keep->a == 7);
+
+    // the 3 free blocks of the surviving slab are still handed out before a new slab
+    set<TestData*> reused;
+    for (int i = 0; i < 3; ++i) reused.insert(pool.allocate());
+    REQUIRE(pool.slab_count() == 1);
+    REQUIRE(reused.count(keep) == 0);
+    TestData* fresh = pool.allocate();
+    REQUIRE(pool.slab_count() == 2);
+
+    for (auto* p : reused) pool.deallocate(p);
+    pool.deallocate(keep);
+    pool.deallocate(fresh);
+    REQUIRE(pool.trim() == 2 * pool.slab_bytes());
+    REQUIRE(pool.capacity() == 0);
+    TestData* again = pool.allocate();  // grows back from nothing
+    REQUIRE(again != nullptr);
+    REQUIRE(pool.capacity() == 4);
+    pool.deallocate(again);
+}
+
+TEST_CASE("mem pool huge pages", "[mem pool]") {
+    MemPool<TestData, 1000> pool(0, true);
+    TestData* p = pool.allocate();
+    REQUIRE(pool.slab_bytes() % (2 << 20) == 0);
+    REQUIRE(pool.capacity() == pool.slab_bytes() / sizeof(TestData));
+    // blocks are carved from the end, the slab itself starts on a huge page boundary
+    auto base = reinterpret_cast<uintptr_t>(p) - (pool.capacity() - 1) * sizeof(TestData);
+    REQUIRE(base % (2 << 20) == 0);
+    p->a = 1;
+    pool.deallocate(p);
+    REQUIRE(pool.trim() == pool.slab_bytes());
+}
@@ -0,0 +1,90 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "zerg/tool/object_pool.h"
+
+using namespace zerg;
+using namespace std;
+
+namespace {
+struct Quote {
+    static int alive;
+    string symbol;
+    double px;
+    Quote(string s, double p) : symbol(std::move(s)), px(p) {
+        if (px < 0) throw invalid_argument("negative price");
+        ++alive;
+    }
+    ~Quote() { --alive; }
+};
+int Quote::alive = 0;
+}  // namespace
+
+TEST_CASE("object pool constructs and destroys", "[object pool]") {
+    ObjectPool<Quote, 8> pool;
+    REQUIRE(pool.capacity() == 0);  // lazy by default
+    {
+        auto q = pool.create("IF2501", 3800.2);
+        REQUIRE(q->symbol == "IF2501");
+        REQUIRE(q->px == 3800.2);
+        REQUIRE(Quote::alive == 1);
+        REQUIRE(pool.live() == 1);
+        REQUIRE(pool.capacity() == 8);
+    }
+    REQUIRE(Quote::alive == 0);
+    REQUIRE(pool.live() == 0);
+
+    vector<ObjectPool<Quote, 8>::Ptr> book;
+    for (int i = 0; i < 20; ++i) book.push_back(pool.create(to_string(i), i));
+    REQUIRE(Quote::alive == 20);
+    REQUIRE(pool.capacity() == 24);
+    book.resize(5);
+    REQUIRE(Quote::alive == 5);
+    REQUIRE(pool.live() == 5);
+    REQUIRE(pool.peak() == 20);
+    REQUIRE(pool.total() == 21);
+
+    // freed slots are reused before growing
+    for (int i = 0; i < 15; ++i) book.push_back(pool.create("x", 1));
+    REQUIRE(pool.capacity() == 24);
+    book.clear();
+    REQUIRE(Quote::alive == 0);
+}
+
+TEST_CASE("object pool constructor failure returns the slot", "[object pool]") {
+    ObjectPool<Quote, 4> pool(PoolGrowth::Eager, 8);
+    REQUIRE(pool.capacity() == 8);
+    REQUIRE_THROWS_AS(pool.create("bad", -1.0), invalid_argument);
+    REQUIRE(pool.live() == 0);
+    REQUIRE(pool.total() == 0);
+
+    Quote* raw = pool.create_raw("ok", 1.0);
+    REQUIRE(pool.live() == 1);
+    pool.destroy(raw);
+    REQUIRE(pool.live() == 0);
+    REQUIRE(Quote::alive == 0);
+}
+
+TEST_CASE("object pool of small objects", "[object pool]") {
+    ObjectPool<char, 16> pool;  // narrower than the free list pointer
+    auto a = pool.create('a');
+    auto b = pool.create('b');
+    REQUIRE(*a == 'a');
+    REQUIRE(*b == 'b');
+    a.reset();
+    auto c = pool.create('c');
+    REQUIRE(*c == 'c');
+    REQUIRE(*b == 'b');
+}
+
+TEST_CASE("object pool trim after a burst", "[object pool]") {
+    ObjectPool<Quote, 8> pool;
+    vector<ObjectPool<Quote, 8>::Ptr> burst;
+    for (int i = 0; i < 40; ++i) burst.push_back(pool.create("b", i));
+    auto keep = pool.create("keep", 1);
+    burst.clear();
+    REQUIRE(pool.trim() > 0);
+    REQUIRE(pool.capacity() == 8);  // the slab of keep
+    REQUIRE(keep->symbol == "keep");
+}
@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "catch.hpp"
+#include "zerg/tool/parallel.h"
+#include "zerg/tool/work_stealing_pool.h"
+
+using namespace zerg;
+using namespace std;
+
+TEST_CASE("parallel_for covers every index once", "[parallel]") {
+    std::vector<int> hits(10007, 0);
+    parallel_for({0, (int64_t)hits.size()}, 100, [&](int64_t b, int64_t e) {
+        for (int64_t i = b; i < e; ++i) hits[i]++;
+    });
+    REQUIRE(std::all_of(hits.begin(), hits.end(), [](int h) { return h == 1; }));
+
+    int calls = 0;
+    parallel_for({5, 5}, 10, [&](int64_t, int64_t) { ++calls; });
+    REQUIRE(calls == 0);
+}
+
+TEST_CASE("parallel_reduce is deterministic", "[parallel]") {
+    std::vector<double> v(100000);
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(-1e6, 1e6);
+    for (auto& x : v) x = dist(gen);
+    auto sum = [&](auto& exec) {
+        return parallel_reduce(exec, {0, (int64_t)v.size()}, 1000, 0.0,
+                               [&](int64_t b, int64_t e) { return std::accumulate(v.begin() + b, v.begin() + e, 0.0); },
+                               [](double a, double b) { return a + b; });
+    };
+    ThreadPool p1(1);
+    ThreadPool p4(4);
+    WorkStealingPool ws(3);
+    OpenMPExec omp;
+    double r1 = sum(p1);
+    // same bits whatever the executor and thread count
+    REQUIRE(sum(p4) == r1);
+    REQUIRE(sum(ws) == r1);
+    REQUIRE(sum(omp) == r1);
+}
+
+TEST_CASE("parallel_sort", "[parallel]") {
+    std::vector<int> v(300001);
+    std::mt19937 gen(7);
+    for (auto& x : v) x = static_cast<int>(gen() % 1000);
+    auto expect = v;
+    std::sort(expect.begin(), expect.end());
+    auto v2 = v;
+    parallel_sort(v.begin(), v.end());
+    REQUIRE(v == expect);
+    ThreadPool pool(3);
+    parallel_sort(pool, v2.begin(), v2.end(), std::greater<int>(), 1000);
+    REQUIRE(std::is_sorted(v2.begin(), v2.end(), std::greater<int>()));
+}
+
+TEST_CASE("parallel_for nested and exceptions", "[parallel]") {
+    ThreadPool pool(2);
+    std::atomic<int64_t> total{0};
+    // every outer chunk blocks a worker, inner loops must still finish
+    parallel_for(pool, {0, 8}, 1, [&](int64_t, int64_t) {
+        parallel_for(pool, {0, 100}, 10, [&](int64_t b, int64_t e) { total += e - b; });
+    });
+    REQUIRE(total == 800);
+
+    REQUIRE_THROWS_AS(parallel_for(pool, {0, 100}, 1,
+                                   [](int64_t b, int64_t) {
+                                       if (b == 37) throw std::runtime_error("bad row");
+                                   }),
+                      std::runtime_error);
+}
@@ -0,0 +1,80 @@
+#include <unistd.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include "catch.hpp"
+#include "zerg/tool/pipeline.h"
+
+using namespace zerg;
+using namespace std;
+
+struct PipeJob {
+    int id{0};
+    int64_t value{0};
+};
+
+TEST_CASE("pipeline keeps input order", "[pipeline]") {
+    Pipeline<PipeJob> pipe(4);
+    std::vector<int> out;
+    pipe.stage("load", 3,
+               [](PipeJob& j) {
+                   usleep((7 - j.id % 7) * 100);  // later items tend to finish first
+                   j.value = j.id;
+               })
+        .stage("calc", 2, [](PipeJob& j) { j.value *= j.value; })
+        .sink([&](PipeJob& j) {
+            REQUIRE(j.value == int64_t(j.id) * j.id);
+            out.push_back(j.id);
+        });
+    std::vector<PipeJob> jobs(50);
+    for (int i = 0; i < 50; ++i) jobs[i].id = i;
+    pipe.run(jobs);
+    REQUIRE(out.size() == 50);
+    for (int i = 0; i < 50; ++i) REQUIRE(out[i] == i);
+
+    auto stats = pipe.stats();
+    REQUIRE(stats.size() == 3);
+    REQUIRE(stats[0].items == 50);
+    REQUIRE(stats[1].name == "calc");
+    REQUIRE(stats[2].items == 50);
+
+    // can run again
+    out.clear();
+    pipe.run(10, [](size_t i) { return PipeJob{int(i), 0}; });
+    REQUIRE(out.size() == 10);
+}
+
+TEST_CASE("pipeline bounds items in flight", "[pipeline]") {
+    const int max_in_flight = 3;
+    Pipeline<PipeJob> pipe(max_in_flight);
+    std::atomic<int> alive{0};
+    int peak = 0;
+    pipe.stage("a", 4, [](PipeJob&) { usleep(200); }).stage("b", 1, [](PipeJob&) { usleep(100); }).sink([&](PipeJob&) {
+        peak = std::max(peak, alive.load());
+        --alive;
+    });
+    pipe.run(40, [&](size_t i) {
+        ++alive;
+        return PipeJob{int(i), 0};
+    });
+    REQUIRE(alive == 0);
+    REQUIRE(peak <= max_in_flight);
+}
+
+TEST_CASE("pipeline rethrows stage errors", "[pipeline]") {
+    Pipeline<PipeJob> pipe(2);
+    int sunk = 0;
+    pipe.stage("load", 2,
+               [](PipeJob& j) {
+                   if (j.id == 5) throw std::runtime_error("bad date");
+               })
+        .sink([&](PipeJob&) { ++sunk; });
+    REQUIRE_THROWS_AS(pipe.run(100, [](size_t i) { return PipeJob{int(i), 0}; }), std::runtime_error);
+    REQUIRE(sunk <= 5);
+
+    Pipeline<PipeJob> no_stage;
+    no_stage.sink([](PipeJob& j) {
+        if (j.id == 1) throw std::logic_error("sink");
+    });
+    REQUIRE_THROWS_AS(no_stage.run(3, [](size_t i) { return PipeJob{int(i), 0}; }), std::logic_error);
+}
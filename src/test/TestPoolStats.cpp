@@ -0,0 +1,71 @@
+#include <chrono>
+#include <thread>
+#include "catch.hpp"
+#include "zerg/tool/histogram.h"
+#include "zerg/tool/pool_stats.h"
+#include "zerg/tool/thread_pool.h"
+#include "zerg/tool/work_stealing_pool.h"
+
+using namespace zerg;
+using namespace std;
+
+TEST_CASE("histogram buckets", "[pool stats]") {
+    for (uint64_t v : {0ULL, 1ULL, 3ULL, 4ULL, 7ULL, 8ULL, 1000ULL, 123456789ULL, (1ULL << 63) + 5}) {
+        int idx = Histogram::bucket_of(v);
+        REQUIRE(idx < Histogram::BUCKETS);
+        REQUIRE(Histogram::bucket_lower(idx) <= v);
+        REQUIRE(v <= Histogram::bucket_upper(idx));
+    }
+    Histogram h;
+    for (uint64_t v = 1; v <= 1000; ++v) h.record(v);
+    auto s = h.snapshot();
+    REQUIRE(s.count == 1000);
+    REQUIRE(s.max == 1000);
+    REQUIRE(s.mean() == Approx(500.5));
+    // within one bucket (25%) of the exact value
+    REQUIRE(s.percentile(0.5) >= 500);
+    REQUIRE(s.percentile(0.5) <= 640);
+    REQUIRE(s.percentile(1.0) == 1000);
+    h.reset();
+    REQUIRE(h.snapshot().count == 0);
+}
+
+TEST_CASE("thread pool stats", "[pool stats]") {
+    ThreadPoolT<BlockingWait, PoolStats> pool(2);
+    for (int i = 0; i < 100; ++i) {
+        pool.submit([] { std::this_thread::sleep_for(std::chrono::microseconds(100)); });
+    }
+    pool.wait_all();
+    auto s = pool.stats().snapshot();
+    REQUIRE(s.pushed == 100);
+    REQUIRE(s.executed == 100);
+    REQUIRE(s.exec_ns.count == 100);
+    REQUIRE(s.wait_ns.count == 100);
+    REQUIRE(s.exec_ns.percentile(0.5) >= 100000);
+    REQUIRE(s.queue_hwm >= 2);
+    REQUIRE(s.busy_ratio.size() == 2);
+    REQUIRE(s.busy_ratio[0] + s.busy_ratio[1] > 0);
+    REQUIRE(s.to_string().find("executed 100") != std::string::npos);
+
+    int dumps = 0;
+    pool.stats().start_dump(std::chrono::milliseconds(1), [&](const PoolStatsSnapshot&) { ++dumps; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    pool.stats().stop_dump();
+    REQUIRE(dumps > 0);
+}
+
+TEST_CASE("work stealing pool stats", "[pool stats]") {
+    WorkStealingPoolT<BlockingWait, PoolStats> pool(2);
+    std::vector<std::future<void>> fs;
+    for (int i = 0; i < 50; ++i) fs.push_back(pool.enqueue([] {}));
+    for (auto& f : fs) f.get();
+    // futures are ready before on_done is recorded, wait for the counter with a deadline
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    auto s = pool.stats().snapshot();
+    while (s.executed < 50 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        s = pool.stats().snapshot();
+    }
+    REQUIRE(s.pushed == 50);
+    REQUIRE(s.executed == 50);
+}
@@ -0,0 +1,84 @@
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+#include "zerg/tool/spin_lock.h"
+
+using namespace zerg;
+using namespace std;
+
+template <typename TLock>
+static int64_t contend(int threads, int n) {
+    TLock lock;
+    int64_t counter = 0;
+    std::vector<std::thread> ts;
+    for (int t = 0; t < threads; ++t) {
+        ts.emplace_back([&] {
+            for (int i = 0; i < n; ++i) {
+                std::lock_guard<TLock> guard(lock);
+                ++counter;
+            }
+        });
+    }
+    for (auto& t : ts) t.join();
+    return counter;
+}
+
+TEST_CASE("spin locks mutual exclusion", "[spin lock]") {
+    REQUIRE(contend<TicketSpinLock>(4, 20000) == 80000);
+    REQUIRE(contend<SpinFutexMutex>(4, 20000) == 80000);
+    REQUIRE(contend<ShmSpinFutexMutex>(4, 20000) == 80000);
+    REQUIRE(contend<RWSpinLock>(4, 20000) == 80000);
+}
+
+TEST_CASE("spin locks try_lock", "[spin lock]") {
+    TicketSpinLock ticket;
+    REQUIRE(ticket.try_lock());
+    REQUIRE_FALSE(ticket.try_lock());
+    ticket.unlock();
+    REQUIRE(ticket.try_lock());
+    ticket.unlock();
+
+    SpinFutexMutex mutex;
+    REQUIRE(mutex.try_lock());
+    REQUIRE_FALSE(mutex.try_lock());
+    mutex.unlock();
+
+    RWSpinLock rw;
+    REQUIRE(rw.try_lock_shared());
+    REQUIRE(rw.try_lock_shared());
+    REQUIRE_FALSE(rw.try_lock());
+    rw.unlock_shared();
+    rw.unlock_shared();
+    REQUIRE(rw.try_lock());
+    REQUIRE_FALSE(rw.try_lock_shared());
+    rw.unlock();
+}
+
+TEST_CASE("rw spin lock readers see consistent writes", "[spin lock]") {
+    RWSpinLock rw;
+    int64_t a = 0, b = 0;
+    std::atomic<bool> consistent{true};
+    std::thread writer([&] {
+        for (int i = 0; i < 20000; ++i) {
+            std::lock_guard<RWSpinLock> guard(rw);
+            ++a;
+            ++b;
+        }
+    });
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t) {
+        readers.emplace_back([&] {
+            for (int i = 0; i < 20000; ++i) {
+                std::shared_lock<RWSpinLock> guard(rw);
+                if (a != b) consistent = false;
+            }
+        });
+    }
+    writer.join();
+    for (auto& t : readers) t.join();
+    REQUIRE(consistent);
+    REQUIRE(a == 20000);
+}
@@ -0,0 +1,81 @@
+#include <string>
+#include "catch.hpp"
+#include "zerg/tool/static_event_bus.h"
+
+using namespace zerg;
+using namespace std;
+
+namespace {
+struct Quote {
+    int px;
+};
+
+struct OnQuote {
+    using signature = void(const Quote&);
+};
+
+struct OnAdjust {
+    using signature = void(int& to_change, int delta);
+};
+
+struct Listener {
+    int sum{0};
+    virtual ~Listener() = default;
+    virtual void on_quote(const Quote& q) { sum += q.px; }
+    void on_adjust(int& v, int delta) { v += delta; }
+};
+
+struct Doubler : Listener {
+    void on_quote(const Quote& q) override { sum += 2 * q.px; }
+};
+
+int free_calls = 0;
+void free_handler(const Quote&) { ++free_calls; }
+}  // namespace
+
+TEST_CASE("delegate binds members, functions and functors", "[static event bus]") {
+    Listener l;
+    auto d = make_delegate<&Listener::on_quote>(&l);
+    static_assert(sizeof(d) == 2 * sizeof(void*), "two words");
+    d(Quote{3});
+    REQUIRE(l.sum == 3);
+    REQUIRE(d == Delegate<void(const Quote&)>::bind<&Listener::on_quote>(&l));
+
+    Doubler dbl;
+    make_delegate<&Listener::on_quote>(static_cast<Listener*>(&dbl))(Quote{3});  // virtual dispatch kept
+    REQUIRE(dbl.sum == 6);
+
+    Delegate<void(const Quote&)>::bind<&free_handler>()(Quote{1});
+    REQUIRE(free_calls == 1);
+
+    int hits = 0;
+    auto lambda = [&hits](int x) { return hits += x; };
+    auto f = Delegate<int(int)>::bind_functor(&lambda);
+    REQUIRE(f(5) == 5);
+    REQUIRE_FALSE(Delegate<int(int)>());
+}
+
+TEST_CASE("static event bus fires in subscription order", "[static event bus]") {
+    StaticEventBus<OnQuote, OnAdjust> bus;
+    Listener a;
+    Doubler b;
+    bus.subscribe<OnQuote>(make_delegate<&Listener::on_quote>(&a));
+    bus.subscribe<OnQuote, &Listener::on_quote>(static_cast<Listener*>(&b));
+    bus.subscribe<OnAdjust, &Listener::on_adjust>(&a);
+    bus.subscribe<OnAdjust, &Listener::on_adjust>(&b);
+    REQUIRE(bus.size<OnQuote>() == 2);
+
+    bus.fire<OnQuote>(Quote{10});
+    REQUIRE(a.sum == 10);
+    REQUIRE(b.sum == 20);
+
+    int v = 1;
+    bus.fire<OnAdjust>(v, 5);
+    REQUIRE(v == 11);  // both subscribers saw the same int&
+
+    REQUIRE(bus.unsubscribe<OnQuote>(make_delegate<&Listener::on_quote>(&a)));
+    REQUIRE_FALSE(bus.unsubscribe<OnQuote>(make_delegate<&Listener::on_quote>(&a)));
+    bus.fire<OnQuote>(Quote{1});
+    REQUIRE(a.sum == 10);
+    REQUIRE(b.sum == 22);
+}
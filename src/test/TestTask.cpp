@@ -0,0 +1,81 @@
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+#include "zerg/tool/task.h"
+#include "zerg/tool/thread_pool.h"
+
+using namespace zerg;
+using namespace std;
+
+TEST_CASE("sbo task inline and heap", "[task]") {
+    int hit = 0;
+    SboTask small([&hit] { ++hit; });
+    REQUIRE(small.is_inline());
+    small();
+    REQUIRE(hit == 1);
+
+    std::array<int64_t, 16> big{};
+    big[15] = 5;
+    SboTask large([big, &hit] { hit += static_cast<int>(big[15]); });
+    REQUIRE_FALSE(large.is_inline());
+    large();
+    REQUIRE(hit == 6);
+
+    SboTask moved(std::move(small));
+    REQUIRE_FALSE(small);
+    moved();
+    REQUIRE(hit == 7);
+
+    // captures are destroyed exactly once
+    auto sp = std::make_shared<int>(1);
+    {
+        SboTask a([sp] {});
+        SboTask b;
+        b = std::move(a);
+        REQUIRE(sp.use_count() == 2);
+    }
+    REQUIRE(sp.use_count() == 1);
+}
+
+TEST_CASE("task ring grows in order", "[task]") {
+    TaskRing ring(2);
+    std::vector<int> out;
+    for (int i = 0; i < 40; ++i) ring.push([&out, i] { out.push_back(i); });
+    for (int i = 0; i < 10; ++i) ring.pop()();
+    for (int i = 40; i < 100; ++i) ring.push([&out, i] { out.push_back(i); });
+    while (!ring.empty()) ring.pop()();
+    REQUIRE(out.size() == 100);
+    for (int i = 0; i < 100; ++i) REQUIRE(out[i] == i);
+}
+
+TEST_CASE("latch", "[task]") {
+    Latch latch(3);
+    std::vector<std::thread> ts;
+    for (int i = 0; i < 3; ++i) ts.emplace_back([&] { latch.count_down(); });
+    latch.wait();
+    REQUIRE(latch.try_wait());
+    for (auto& t : ts) t.join();
+    latch.add(2);
+    REQUIRE_FALSE(latch.try_wait());
+    latch.count_down(2);
+    latch.wait();
+}
+
+TEST_CASE("thread pool submit and wait_all", "[task]") {
+    ThreadPool pool(3);
+    std::atomic<int64_t> sum{0};
+    for (int i = 0; i < 1000; ++i) pool.submit([&sum, i] { sum += i; });
+    pool.submit_n(1000, [&sum](size_t i) { sum += static_cast<int64_t>(i); });
+    auto f = pool.enqueue([] { return 1; });
+    pool.wait_all();
+    REQUIRE(sum == 2 * 999 * 1000 / 2);
+    REQUIRE(f.get() == 1);
+
+    // reusable after it drained
+    pool.submit([&sum] { sum = 0; });
+    pool.wait_all();
+    REQUIRE(sum == 0);
+}
@@ -0,0 +1,105 @@
+#include <map>
+#include <random>
+#include <vector>
+#include "catch.hpp"
+#include "zerg/algo/timing_wheel.h"
+
+using namespace zerg;
+using namespace std;
+
+TEST_CASE("timing wheel fires in order", "[timing wheel]") {
+    TimingWheel wheel(1000);  // 1us ticks
+    std::vector<int> fired;
+    wheel.schedule_at(5000, [&] { fired.push_back(5); });
+    wheel.schedule_at(1000, [&] { fired.push_back(1); });
+    wheel.schedule_at(300000, [&] { fired.push_back(300); });      // level 1
+    wheel.schedule_at(70000000, [&] { fired.push_back(70000); });  // level 2
+    auto id = wheel.schedule_at(2000, [&] { fired.push_back(2); });
+    REQUIRE(wheel.size() == 5);
+    REQUIRE(wheel.cancel(id));
+    REQUIRE_FALSE(wheel.cancel(id));
+
+    REQUIRE(wheel.advance(999) == 0);
+    REQUIRE(wheel.advance(4999) == 1);
+    REQUIRE(wheel.advance(299999) == 1);
+    REQUIRE(fired == std::vector<int>{1, 5});
+    REQUIRE(wheel.advance(300000) == 1);
+    REQUIRE(wheel.advance(100000000) == 1);
+    REQUIRE(fired == std::vector<int>{1, 5, 300, 70000});
+    REQUIRE(wheel.empty());
+}
+
+TEST_CASE("timing wheel matches a sorted reference", "[timing wheel]") {
+    TimingWheelT<int> wheel(1);
+    std::mt19937_64 gen(3);
+    std::multimap<uint64_t, int> ref;
+    std::vector<TimingWheelT<int>::TimerId> ids;
+    for (int i = 0; i < 20000; ++i) {
+        // spread over all levels, including past 2^32 ticks
+        uint64_t when = gen() % (1ULL << (8 + (i % 30)));
+        ids.push_back(wheel.schedule_at(when, i));
+        ref.emplace(when, i);
+    }
+    for (int i = 0; i < 20000; i += 3) {
+        REQUIRE(wheel.cancel(ids[i]));
+        for (auto itr = ref.begin(); itr != ref.end(); ++itr) {
+            if (itr->second == i) {
+                ref.erase(itr);
+                break;
+            }
+        }
+    }
+    uint64_t now = 0;
+    uint64_t prev = 0;
+    struct Fired {
+        uint64_t now;   // advance() that fired it
+        uint64_t prev;  // the advance() before
+        int v;
+    };
+    std::vector<Fired> got;
+    while (!wheel.empty()) {
+        prev = now;
+        now += gen() % (1ULL << 28) + 1;
+        wheel.advance(now, [&](TimingWheelT<int>::TimerId, int& v) { got.push_back({now, prev, v}); });
+    }
+    REQUIRE(got.size() == ref.size());
+    // every timer fired in the first advance() at or after its deadline: not before it, and not already due
+    // at the previous advance(), so it is late by less than one tick (1ns here) plus the step between calls
+    std::map<int, uint64_t> deadline;
+    for (auto& kv : ref) deadline[kv.second] = kv.first;
+    size_t early = 0, late = 0;
+    for (auto& g : got) {
+        uint64_t d = deadline[g.v];
+        if (g.now < d) ++early;
+        if (d != 0 && g.prev >= d) ++late;  // deadline 0 is due before the first advance()
+    }
+    REQUIRE(early == 0);
+    REQUIRE(late == 0);
+}
+
+TEST_CASE("timing wheel callbacks reschedule", "[timing wheel]") {
+    TimingWheel wheel(10);
+    int count = 0;
+    std::function<void()> again = [&] {
+        if (++count < 5) wheel.schedule_after(0, [&] { again(); });
+    };
+    wheel.schedule_after(0, [&] { again(); });
+    wheel.advance(0);
+    REQUIRE(count == 1);  // rescheduled timers wait for the next tick
+    wheel.advance(100);
+    REQUIRE(count == 5);
+}
+
+TEST_CASE("timing wheel timerfd driver", "[timing wheel]") {
+    TimingWheel wheel(1000000, monotonic_ns());
+    TimerFdDriver<TimingWheel> driver(wheel);
+    REQUIRE(driver.fd() >= 0);
+    bool fired = false;
+    wheel.schedule_after(2000000, [&] { fired = true; });
+    uint64_t deadline = monotonic_ns() + 1000000000ULL;
+    while (!fired && monotonic_ns() < deadline) {
+        driver.on_readable();
+        usleep(500);
+    }
+    REQUIRE(fired);
+}
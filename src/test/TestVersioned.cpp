@@ -0,0 +1,76 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+#include "zerg/tool/versioned.h"
+
+using namespace zerg;
+using namespace std;
+
+struct Config {
+    explicit Config(int64_t v_, std::atomic<int>* alive_) : v(v_), check(v_ * 7), alive(alive_) { ++*alive; }
+    ~Config() {
+        check = -1;
+        --*alive;
+    }
+    int64_t v;
+    int64_t check;
+    std::atomic<int>* alive;
+};
+
+TEST_CASE("versioned grace period", "[Versioned]") {
+    std::atomic<int> alive{0};
+    Versioned<Config> cfg(std::make_unique<Config>(0, &alive));
+    int slot = cfg.register_reader();
+    const Config* c0 = cfg.get();
+    REQUIRE(c0->v == 0);
+
+    cfg.publish(std::make_unique<Config>(1, &alive));
+    REQUIRE(cfg.get()->v == 1);
+    REQUIRE(alive == 2);  // reader may still hold c0
+    REQUIRE(cfg.reclaim() == 1);
+    REQUIRE(c0->check == 0);
+
+    cfg.quiescent(slot);
+    REQUIRE(cfg.reclaim() == 0);
+    REQUIRE(alive == 1);
+
+    cfg.offline(slot);
+    cfg.publish(std::make_unique<Config>(2, &alive));
+    REQUIRE(alive == 1);  // offline reader does not delay reclamation
+    cfg.unregister_reader(slot);
+}
+
+TEST_CASE("versioned concurrent readers and reload", "[Versioned]") {
+    std::atomic<int> alive{0};
+    {
+        Versioned<Config> cfg(std::make_unique<Config>(0, &alive));
+        std::atomic<bool> stop{false};
+        std::atomic<bool> ok{true};
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 3; ++t) {
+            readers.emplace_back([&] {
+                int slot = cfg.register_reader();
+                int64_t last = 0;
+                while (!stop.load()) {
+                    const Config* c = cfg.get();
+                    if (c->check != c->v * 7 || c->v < last) ok = false;
+                    last = c->v;
+                    cfg.quiescent(slot);
+                }
+                cfg.unregister_reader(slot);
+            });
+        }
+        for (int i = 1; i <= 2000; ++i) cfg.publish(std::make_unique<Config>(i, &alive));
+        for (int i = 2001; i <= 2010; ++i) cfg.reload_async([&, i] { return std::make_unique<Config>(i, &alive); });
+        cfg.reload_async([]() -> std::unique_ptr<Config> { throw std::runtime_error("bad file"); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        stop = true;
+        for (auto& t : readers) t.join();
+        REQUIRE(ok);
+        REQUIRE(cfg.get()->v == 2010);
+        REQUIRE(cfg.reclaim() == 0);
+        REQUIRE(alive == 1);
+    }
+    REQUIRE(alive == 0);
+}
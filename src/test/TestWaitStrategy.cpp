@@ -0,0 +1,46 @@
+#include <thread>
+#include "catch.hpp"
+#include "zerg/algo/SpscQueue.h"
+#include "zerg/tool/thread_pool.h"
+#include "zerg/tool/wait_strategy.h"
+
+using namespace zerg;
+using namespace std;
+
+template <typename TWait>
+static int64_t transfer(int n) {
+    SpscQueue<int64_t, TWait> q(16);
+    int64_t sum = 0;
+    std::thread consumer([&] {
+        for (int i = 0; i < n; ++i) {
+            sum += *q.wait_front();
+            q.pop();
+        }
+    });
+    for (int i = 0; i < n; ++i) q.push(i);
+    consumer.join();
+    return sum;
+}
+
+TEST_CASE("spsc queue with wait strategies", "[wait strategy]") {
+    int n = 20000;
+    int64_t expected = (int64_t)n * (n - 1) / 2;
+    REQUIRE(transfer<SpinYieldWait>(n) == expected);
+    REQUIRE(transfer<SpinFutexWait>(n) == expected);
+    REQUIRE(transfer<BackoffWaitT<10, 1000, 10000>>(n) == expected);
+    REQUIRE(transfer<BlockingWait>(n) == expected);
+}
+
+TEST_CASE("thread pool with wait strategies", "[wait strategy]") {
+    ThreadPoolT<SpinFutexWait> pool(2);
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 100; ++i) {
+        results.push_back(pool.enqueue([](int x) { return x * x; }, i));
+    }
+    int sum = 0;
+    for (auto& r : results) sum += r.get();
+    REQUIRE(sum == 328350);
+
+    ThreadPool default_pool(2);
+    REQUIRE(default_pool.enqueue([] { return 42; }).get() == 42);
+}
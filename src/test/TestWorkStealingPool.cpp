@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+#include "zerg/algo/ChaseLevDeque.h"
+#include "zerg/tool/thread_pool.h"
+#include "zerg/tool/work_stealing_pool.h"
+#include "zerg/unix.h"
+
+using namespace zerg;
+using namespace std;
+
+TEST_CASE("chase lev deque single thread", "[work stealing]") {
+    ChaseLevDeque<int> dq(2);
+    int v = 0;
+    REQUIRE_FALSE(dq.take(v));
+    REQUIRE_FALSE(dq.steal(v));
+    for (int i = 0; i < 100; ++i) dq.push(i);  // grows several times
+    REQUIRE(dq.size() == 100);
+    REQUIRE(dq.take(v));
+    REQUIRE(v == 99);
+    REQUIRE(dq.steal(v));
+    REQUIRE(v == 0);
+    REQUIRE(dq.size() == 98);
+}
+
+TEST_CASE("chase lev deque concurrent steal", "[work stealing]") {
+    ChaseLevDeque<int> dq(16);
+    const int N = 200000;
+    std::atomic<bool> done{false};
+    std::vector<std::vector<int>> got(4);
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; ++t) {
+        thieves.emplace_back([&, t] {
+            int v;
+            while (!done.load(std::memory_order_acquire) || !dq.empty()) {
+                if (dq.steal(v)) got[t].push_back(v);
+            }
+        });
+    }
+    int v;
+    for (int i = 0; i < N; ++i) {
+        dq.push(i);
+        if (i % 3 == 0 && dq.take(v)) got[3].push_back(v);
+    }
+    while (dq.take(v)) got[3].push_back(v);
+    done = true;
+    for (auto& t : thieves) t.join();
+
+    std::set<int> all;
+    size_t total = 0;
+    for (auto& g : got) {
+        total += g.size();
+        all.insert(g.begin(), g.end());
+    }
+    REQUIRE(total == N);  // no task taken twice
+    REQUIRE(all.size() == N);
+}
+
+TEST_CASE("work stealing pool enqueue", "[work stealing]") {
+    WorkStealingPool pool(4);
+    std::vector<std::future<int>> fs;
+    for (int i = 0; i < 1000; ++i) fs.push_back(pool.enqueue([](int x) { return x * 2; }, i));
+    int64_t sum = 0;
+    for (auto& f : fs) sum += f.get();
+    REQUIRE(sum == 999 * 1000);
+    REQUIRE(pool.this_worker() == -1);
+}
+
+static int64_t fib(WorkStealingPool& pool, int n) {
+    if (n < 12) {
+        int64_t a = 0, b = 1;
+        for (int i = 0; i < n; ++i) {
+            int64_t c = a + b;
+            a = b;
+            b = c;
+        }
+        return a;
+    }
+    auto left = pool.enqueue(fib, std::ref(pool), n - 1);
+    int64_t right = fib(pool, n - 2);
+    return pool.join(left) + right;
+}
+
+TEST_CASE("work stealing pool recursive fork join", "[work stealing]") {
+    // 2 workers and deep recursion, future.get() inside tasks would deadlock here
+    WorkStealingPool pool(2);
+    auto f = pool.enqueue(fib, std::ref(pool), 25);
+    REQUIRE(f.get() == 75025);
+}
+
+TEST_CASE("work stealing pool drains on destruction", "[work stealing]") {
+    std::atomic<int> count{0};
+    {
+        WorkStealingPool pool(3);
+        for (int i = 0; i < 100; ++i) {
+            pool.enqueue([&] {
+                for (int j = 0; j < 10; ++j) pool.enqueue([&] { ++count; });
+            });
+        }
+    }
+    REQUIRE(count == 1000);
+}
+
+TEST_CASE("cpu list and topology", "[work stealing]") {
+    REQUIRE(ParseCpuList("0-3,8,10-11") == std::vector<size_t>{0, 1, 2, 3, 8, 10, 11});
+    REQUIRE(ParseCpuList("").empty());
+    REQUIRE(GetNumaNodeCount() >= 1);
+    auto cores = GetPhysicalCores();
+    REQUIRE_FALSE(cores.empty());
+    REQUIRE(cores.size() <= GetOnlineCpus().size());
+}
+
+TEST_CASE("pinned pools and node hint", "[work stealing]") {
+    auto cpus = GetAffinity();
+    auto affinity = PoolAffinity::Cores({cpus.front(), cpus.back()});
+    REQUIRE(affinity.nodes.size() == 2);
+    {
+        ThreadPool pool(affinity);
+        auto f = pool.enqueue([] { return GetAffinity(); });
+        auto pinned = f.get();
+        REQUIRE(pinned.size() == 1);
+        REQUIRE((pinned[0] == cpus.front() || pinned[0] == cpus.back()));
+    }
+    WorkStealingPool pool(affinity);
+    int node = affinity.nodes[0];
+    std::vector<std::future<int>> fs;
+    for (int i = 0; i < 100; ++i) {
+        fs.push_back(pool.enqueue_on(node, [&pool] { return pool.node_of(pool.this_worker()); }));
+    }
+    for (auto& f : fs) REQUIRE(f.get() == node);
+    // unknown node falls back to any worker
+    REQUIRE(pool.enqueue_on(1000, [] { return 7; }).get() == 7);
+}
+
+TEST_CASE("empty and invalid affinity", "[work stealing]") {
+    {
+        ThreadPool pool{PoolAffinity()};
+        REQUIRE(pool.size() >= 1);
+        REQUIRE(pool.enqueue([] { return 3; }).get() == 3);
+    }
+    {
+        WorkStealingPool pool{PoolAffinity()};
+        REQUIRE(pool.enqueue([] { return 4; }).get() == 4);
+    }
+    auto bad = PoolAffinity::Cores({GetAffinity().front(), 4000});
+    REQUIRE_THROWS_AS(ThreadPool(bad), std::invalid_argument);
+    REQUIRE_THROWS_AS(WorkStealingPool(bad), std::invalid_argument);
+    auto allowed = GetAffinity();
+    for (size_t cpu : PoolAffinity::PhysicalCores().cores) {
+        REQUIRE(std::find(allowed.begin(), allowed.end(), cpu) != allowed.end());
+    }
+}
+
+TEST_CASE("node task waiting for its node does not spin other nodes", "[work stealing]") {
+    // two pretend nodes on one cpu, worker 1 is the only one of node 1
+    size_t cpu = GetAffinity().front();
+    PoolAffinity affinity;
+    affinity.cores = {cpu, cpu};
+    affinity.nodes = {0, 1};
+    WorkStealingPool pool(affinity);
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::promise<void> started;
+    auto busy = pool.enqueue_on(1, [&started, released] {
+        started.set_value();
+        released.wait();
+    });
+    started.get_future().wait();
+    auto queued = pool.enqueue_on(1, [&pool] { return pool.this_worker(); });
+
+    auto cpu_ns = [] {
+        timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return ts.tv_sec * 1000000000L + ts.tv_nsec;
+    };
+    int64_t begin = cpu_ns();
+    this_thread::sleep_for(chrono::milliseconds(200));
+    int64_t used = cpu_ns() - begin;
+    REQUIRE(used < 50000000);  // worker 0 sleeps instead of polling for the node 1 task
+
+    release.set_value();
+    busy.get();
+    REQUIRE(queued.get() == 1);
+    REQUIRE(pool.enqueue([] { return 5; }).get() == 5);  // worker 0 still serves everything else
+}
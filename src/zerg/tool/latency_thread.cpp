@@ -0,0 +1,176 @@
+#include <zerg/tool/latency_thread.h>
+#include <alloca.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <memory>
+#include <zerg/log.h>
+#include <zerg/unix.h>
+
+namespace zerg {
+
+static uint64_t MonotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+static bool Contains(const std::vector<size_t>& cpus, int core) {
+    return core >= 0 && std::find(cpus.begin(), cpus.end(), static_cast<size_t>(core)) != cpus.end();
+}
+
+// touch every page of the next bytes of stack, noinline so the frame really is below the caller
+__attribute__((noinline)) static void PrefaultStack(size_t bytes) {
+    if (bytes == 0) return;
+    auto* p = static_cast<volatile char*>(alloca(bytes));
+    for (size_t i = 0; i < bytes; i += 4096) p[i] = 0;
+    Escape(const_cast<char*>(p));
+}
+
+Histogram::Snapshot MeasureJitter(int ms, uint64_t threshold_ns, uint64_t* hiccups) {
+    // plain buckets on this thread, the atomic adds of Histogram::record would land in every gap
+    Histogram::Snapshot snap;
+    uint64_t over = 0;
+    uint64_t prev = MonotonicNs();
+    uint64_t end = prev + static_cast<uint64_t>(ms) * 1000000ULL;
+    while (prev < end) {
+        uint64_t now = MonotonicNs();
+        uint64_t gap = now - prev;
+        ++snap.buckets[Histogram::bucket_of(gap)];
+        snap.sum += gap;
+        if (gap > snap.max) snap.max = gap;
+        if (gap > threshold_ns) ++over;
+        prev = now;
+    }
+    for (uint64_t b : snap.buckets) snap.count += b;
+    if (hiccups) *hiccups = over;
+    return snap;
+}
+
+std::string LatencyThreadReport::to_string() const {
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "core %d pinned %d fifo %d mlock %d isolated %d nohz_full %d jitter p50 %luns p99 %luns p99.99 %luns "
+             "max %luns hiccups %lu",
+             core, pinned, realtime, memory_locked, isolated, nohz_full,
+             static_cast<unsigned long>(jitter.percentile(0.5)), static_cast<unsigned long>(jitter.percentile(0.99)),
+             static_cast<unsigned long>(jitter.percentile(0.9999)), static_cast<unsigned long>(jitter.max),
+             static_cast<unsigned long>(hiccups));
+    return buf;
+}
+
+namespace {
+struct StartContext {
+    LatencyThreadConfig config;
+    std::function<void()> fn;
+    LatencyThreadReport report;
+    std::promise<LatencyThreadReport> ready;
+};
+
+void* LatencyThreadMain(void* arg) {
+    std::unique_ptr<StartContext> ctx(static_cast<StartContext*>(arg));
+    auto& cfg = ctx->config;
+    auto& report = ctx->report;
+    std::function<void()> fn;
+    try {
+        if (!cfg.name.empty()) pthread_setname_np(pthread_self(), cfg.name.substr(0, 15).c_str());
+        if (cfg.core >= 0) {
+            BindCore(static_cast<size_t>(cfg.core));
+            report.pinned = true;
+        }
+        if (cfg.rt_priority > 0) {
+            sched_param param{};
+            param.sched_priority = std::min(cfg.rt_priority, sched_get_priority_max(SCHED_FIFO));
+            int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+            if (err == 0) {
+                report.realtime = true;
+            } else {
+                ZLOG("WARN, %s SCHED_FIFO %d failed: %s", cfg.name.c_str(), cfg.rt_priority, strerror(err));
+            }
+        }
+        PrefaultStack(std::min(cfg.prefault_stack, cfg.stack_size ? cfg.stack_size / 2 : cfg.prefault_stack));
+        if (cfg.prefault) cfg.prefault();
+        if (cfg.calibrate_ms > 0) report.jitter = MeasureJitter(cfg.calibrate_ms, cfg.jitter_threshold_ns, &report.hiccups);
+        fn = std::move(ctx->fn);
+        ctx->ready.set_value(report);
+    } catch (...) {
+        ctx->ready.set_exception(std::current_exception());
+        return nullptr;
+    }
+    ctx.reset();  // free the setup state before the long running fn
+    fn();
+    return nullptr;
+}
+}  // namespace
+
+LatencyThread spawn_latency_thread(const LatencyThreadConfig& config, std::function<void()> fn) {
+    LatencyThread ret;
+    auto& report = ret.m_report;
+    report.core = config.core;
+    report.isolated = Contains(GetIsolatedCpus(), config.core);
+    report.nohz_full = Contains(GetNohzFullCpus(), config.core);
+    if (config.core >= 0 && !report.isolated) {
+        if (config.require_isolated) ZLOG_THROW("core %d of %s is not isolated", config.core, config.name.c_str());
+        ZLOG("WARN, core %d of %s is not isolated, add it to isolcpus=", config.core, config.name.c_str());
+    }
+    if (config.lock_memory) {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+            report.memory_locked = true;
+        } else {
+            ZLOG("WARN, mlockall for %s failed: %s", config.name.c_str(), strerror(errno));
+        }
+    }
+
+    auto* ctx = new StartContext{config, std::move(fn), report, {}};
+    auto ready = ctx->ready.get_future();
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (config.stack_size > 0) pthread_attr_setstacksize(&attr, config.stack_size);
+    int err = pthread_create(&ret.m_thread, &attr, LatencyThreadMain, ctx);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        delete ctx;
+        ZLOG_THROW("pthread_create for %s failed: %s", config.name.c_str(), strerror(err));
+    }
+    ret.m_joinable = true;
+    try {
+        report = ready.get();
+    } catch (...) {
+        ret.join();
+        throw;
+    }
+    ZLOG("latency thread %s: %s", config.name.c_str(), report.to_string().c_str());
+    return ret;
+}
+
+LatencyThread::LatencyThread(LatencyThread&& other) noexcept
+    : m_thread(other.m_thread), m_joinable(other.m_joinable), m_report(other.m_report) {
+    other.m_joinable = false;
+}
+
+LatencyThread& LatencyThread::operator=(LatencyThread&& other) noexcept {
+    if (this != &other) {
+        if (m_joinable) join();
+        m_thread = other.m_thread;
+        m_joinable = other.m_joinable;
+        m_report = other.m_report;
+        other.m_joinable = false;
+    }
+    return *this;
+}
+
+LatencyThread::~LatencyThread() {
+    if (m_joinable) join();
+}
+
+void LatencyThread::join() {
+    if (!m_joinable) return;
+    pthread_join(m_thread, nullptr);
+    m_joinable = false;
+}
+}  // namespace zerg
@@ -8,6 +8,7 @@
 #include <fstream>
 #include <ios>
 #include <iostream>
+#include <algorithm>
 #include <cstring>
 #include <zerg/unix.h>
 #include <zerg/log.h>
@@ -171,6 +172,77 @@ void BindCore(std::vector<size_t>& cpu_id_list) {
     if (sched_setaffinity(0, sizeof(mask), &mask) != 0) ZLOG_THROW("CPU affinity setting failed.");
 }
 
+static std::string ReadSysFile(const std::string& path) {
+    std::ifstream ifs(path);
+    std::string line;
+    if (ifs) std::getline(ifs, line);
+    return line;
+}
+
+std::vector<size_t> ParseCpuList(const std::string& list) {
+    std::vector<size_t> ret;
+    for (auto& item : split(list, ',')) {
+        if (item.empty()) continue;
+        auto pos = item.find('-');
+        size_t first = std::stoul(item.substr(0, pos));
+        size_t last = pos == std::string::npos ? first : std::stoul(item.substr(pos + 1));
+        for (size_t cpu = first; cpu <= last; ++cpu) ret.push_back(cpu);
+    }
+    return ret;
+}
+
+std::vector<size_t> GetOnlineCpus() {
+    auto ret = ParseCpuList(ReadSysFile("/sys/devices/system/cpu/online"));
+    if (ret.empty()) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long i = 0; i < n; ++i) ret.push_back(i);
+    }
+    return ret;
+}
+
+int GetNumaNodeCount() {
+    auto nodes = ParseCpuList(ReadSysFile("/sys/devices/system/node/online"));
+    return nodes.empty() ? 1 : static_cast<int>(nodes.back() + 1);
+}
+
+std::vector<size_t> GetNodeCpus(int node) {
+    std::string list = ReadSysFile("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if (list.empty()) return node == 0 ? GetOnlineCpus() : std::vector<size_t>{};
+    return ParseCpuList(list);
+}
+
+int GetCpuNode(size_t cpu_id) {
+    int nodes = GetNumaNodeCount();
+    for (int node = 0; node < nodes; ++node) {
+        auto cpus = GetNodeCpus(node);
+        if (std::find(cpus.begin(), cpus.end(), cpu_id) != cpus.end()) return node;
+    }
+    return 0;
+}
+
+std::vector<size_t> GetPhysicalCores(int node) {
+    std::vector<size_t> ret;
+    std::vector<std::pair<std::string, std::string>> seen;  // (package, core id)
+    for (size_t cpu : node < 0 ? GetOnlineCpus() : GetNodeCpus(node)) {
+        std::string topo = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        std::string package = ReadSysFile(topo + "physical_package_id");
+        std::string core = ReadSysFile(topo + "core_id");
+        if (core.empty()) core = std::to_string(cpu);  // unknown topology, every cpu is a core
+        auto key = std::make_pair(package, core);
+        if (std::find(seen.begin(), seen.end(), key) != seen.end()) continue;  // hyper-thread sibling
+        seen.push_back(key);
+        ret.push_back(cpu);
+    }
+    return ret;
+}
+
+std::vector<size_t> GetIsolatedCpus() { return ParseCpuList(ReadSysFile("/sys/devices/system/cpu/isolated")); }
+
+std::vector<size_t> GetNohzFullCpus() {
+    std::string list = ReadSysFile("/sys/devices/system/cpu/nohz_full");
+    if (list.empty() || list[0] == '(') return {};  // "(null)" when not configured
+    return ParseCpuList(list);
+}
 
 void System::Init() {
     struct timespec start;